@@ -0,0 +1,43 @@
+#!/bin/bash
+
+#	Convert xtest benchmark logs (bench.sh output, bench_*.txt) into
+#	xbench baseline records:
+#		bench/bench2csv.sh ../ref-data/bench/bench_*.txt > base.csv
+#		./xbench -c base.csv
+#	The logs have no latency deviation (sd_ns = 0, so only the -T
+#	tolerance applies) and the stack figure is the frame of the
+#	racc_core_*() function only, from racc_core.su.
+
+echo "param,op,threads,iterations,ns_op,sd_ns,cycles_op,stack,backend"
+
+awk -F '\t' '
+function flush(   i, o) {
+	for (i = 0; i < 3; i++) {
+		o = ops[i];
+		if (o in ns)
+			printf("%s,%s,1,%d,%.1f,0.0,%.1f,%d,ntt64+lfsr127\n",
+				param, o, it[o], ns[o], cyc[o], stk[o]);
+	}
+	delete ns; delete it; delete cyc; delete stk;
+}
+BEGIN {
+	ops[0] = "KeyGen"; ops[1] = "Sign"; ops[2] = "Verify";
+	su["core_keygen"] = "KeyGen";
+	su["core_sign"] = "Sign";
+	su["core_verify"] = "Verify";
+}
+FNR == 1 && NR > 1 { flush() }
+/^CRYPTO_ALGNAME/ { sub(/.*= */, ""); param = $0 }
+$2 ~ /^ *(KeyGen|Sign|Verify)\(\) +[0-9]+:/ {
+	split($2, a, " ");
+	o = a[1]; sub(/\(\)/, "", o);
+	it[o] = a[2] + 0;
+	ns[o] = 1E6 * ($3 + 0);
+	cyc[o] = 1E6 * ($4 + 0);
+}
+$1 ~ /_core_(keygen|sign|verify)$/ {
+	f = $1; sub(/.*_core_/, "core_", f);
+	stk[su[f]] = $2 + 0;
+}
+END { flush() }
+' "$@"
@@ -0,0 +1,896 @@
+//  bench_main.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Multi-threaded throughput and latency benchmark (xbench).
+
+#ifndef NIST_KAT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "plat_local.h"
+#include "nist_random.h"
+#include "bench_util.h"
+#include "bench_perf.h"
+#include "racc_prof.h"
+#include "racc_core.h"
+#include "aes_ni.h"
+#include "api.h"
+
+//  default message size ("abc")
+#define DEF_MSG 3
+
+//  operations
+enum { OP_KEYGEN, OP_SIGN, OP_VERIFY, OP_VERIFY_PIPE, OP_NUM };
+
+static const char *op_name[OP_NUM] = {
+    "KeyGen", "Sign", "Verify", "VerifyPipe"
+};
+
+//  the profiler hook stores one value per hardware event
+typedef char ev_num_check[BENCH_PERF_NUM == RACC_PROF_EV ? 1 : -1];
+
+//  output formats
+enum { FMT_TEXT, FMT_CSV, FMT_JSON };
+
+//  a result record (also used for baseline records)
+
+typedef struct {
+    char param[32];                         //  CRYPTO_ALGNAME
+    char op[16];                            //  op_name[]
+    int thr;                                //  number of threads
+    size_t n;                               //  iterations (all threads)
+    double ns, sd;                          //  latency mean and sd (ns)
+    double cyc;                             //  cycles per operation
+    size_t stack;                           //  peak stack usage (bytes)
+    char backend[64];                       //  build options
+} bench_rec_t;
+
+//  maximum number of baseline records
+#define MAX_BASE 1024
+
+//  significance of a difference in means (Welch's t statistic)
+#define SIG_T 3.0
+
+//  options
+
+typedef struct {
+    double secs;                            //  measurement time
+    size_t max_n;                           //  maximum samples per thread
+    bool histo;                             //  latency histograms
+    bool prof;                              //  per-phase profile
+    bool attempts;                          //  signing attempts
+    bool perf;                              //  hardware counters
+    bool res;                               //  buffered randombytes()
+    size_t mlen;                            //  message size
+    int fmt;                                //  output format
+    double tol;                             //  regression tolerance
+    bench_rec_t *base;                      //  baseline records
+    size_t base_n;                          //  number of baseline records
+} bench_opt_t;
+
+//  per-thread worker state
+
+typedef struct {
+    pthread_t th;                           //  thread handle
+    pthread_barrier_t *bar;                 //  start barrier
+    int id;                                 //  worker number
+    int op;                                 //  operation under test
+    double secs;                            //  measurement time
+    uint64_t *lat;                          //  latency samples (ns)
+    uint8_t *att;                           //  signing attempts (or NULL)
+    size_t max_n, n;                        //  capacity, number of samples
+    uint64_t t0, t1;                        //  start and stop time (ns)
+    uint64_t cyc;                           //  total cycles
+    int fail;                               //  verification failures
+    bool perf;                              //  use hardware counters
+    bool res;                               //  buffered randombytes()
+    bench_perf_t pf;                        //  hardware counters
+    bool ev_ok[BENCH_PERF_NUM];             //  event was available
+    uint64_t ev[BENCH_PERF_NUM];            //  hardware event totals
+    aes256_ctr_drbg_t drbg;                 //  private randombytes()
+    racc_prof_t prof;                       //  profile counters
+    racc_sign_stat_t stat;                  //  signing attempts
+    uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+    uint8_t sk[CRYPTO_SECRETKEYBYTES];
+    uint8_t *sm;                            //  signed message
+    uint8_t *m2;                            //  opened message
+    uint8_t *msg;                           //  message
+    size_t mlen;                            //  message size
+    unsigned long long smlen;
+} worker_t;
+
+//  set up a key and a signed message with the current randombytes()
+
+static void worker_init(worker_t *w)
+{
+    size_t i;
+
+    w->msg = malloc(w->mlen);
+    w->sm = malloc(CRYPTO_BYTES + w->mlen);
+    w->m2 = malloc(CRYPTO_BYTES + w->mlen);
+    if (w->msg == NULL || w->sm == NULL || w->m2 == NULL) {
+        perror("malloc()");
+        exit(1);
+    }
+    for (i = 0; i < w->mlen; i++) {
+        w->msg[i] = 'a' + (i % 3);
+    }
+
+    crypto_sign_keypair(w->pk, w->sk);
+    crypto_sign(w->sm, &w->smlen, w->msg, w->mlen, w->sk);
+}
+
+//  free message buffers
+
+static void worker_free(worker_t *w)
+{
+    free(w->msg);
+    free(w->sm);
+    free(w->m2);
+    w->msg = w->sm = w->m2 = NULL;
+}
+
+//  run the operation under test once
+
+static void worker_op(worker_t *w)
+{
+    unsigned long long mlen2 = 0;
+
+    switch (w->op) {
+        case OP_KEYGEN:
+            crypto_sign_keypair(w->pk, w->sk);
+            break;
+        case OP_SIGN:
+            crypto_sign(w->sm, &w->smlen, w->msg, w->mlen, w->sk);
+            break;
+        case OP_VERIFY:
+            if (crypto_sign_open(w->m2, &mlen2, w->sm, w->smlen, w->pk) != 0)
+                w->fail++;
+            break;
+        case OP_VERIFY_PIPE:
+            if (racc_verify_pipe(w->sm, w->sm + CRYPTO_BYTES,
+                                 w->smlen - CRYPTO_BYTES, w->pk) != 0)
+                w->fail++;
+            break;
+    }
+}
+
+//  thread main: set up a key, wait for others, run op until timeout
+
+static void *worker_main(void *arg)
+{
+    worker_t *w = (worker_t *) arg;
+    uint8_t seed[48];
+    uint64_t t, t_end, cc;
+    uint64_t ev0[BENCH_PERF_NUM], ev1[BENCH_PERF_NUM];
+    size_t i;
+    racc_sign_stat_t sst;
+
+    //  each worker has its own deterministic DRBG and key
+    for (i = 0; i < sizeof(seed); i++) {
+        seed[i] = i + 0x40 * w->id;
+    }
+    aes256ctr_xof_init(&w->drbg, seed);
+    aes256ctr_buffer(&w->drbg, w->res);
+    nist_randombytes_ctx(&w->drbg);
+
+    worker_init(w);
+
+    if (w->perf) {
+        bench_perf_open(&w->pf);
+        for (i = 0; i < BENCH_PERF_NUM; i++) {
+            w->ev_ok[i] = w->pf.fd[i] >= 0;
+        }
+#ifdef RACC_PROFILE
+        bench_perf_thread(&w->pf);
+        racc_prof.ev_read = bench_perf_thread_read;
+#endif
+    }
+
+#ifdef RACC_PROFILE
+    racc_prof_reset();
+#endif
+    racc_sign_stat(NULL, true);
+
+    pthread_barrier_wait(w->bar);
+
+    memset(ev0, 0, sizeof(ev0));
+    if (w->perf)
+        bench_perf_read(&w->pf, ev0);
+
+    w->t0 = bench_ns();
+    t_end = w->t0 + (uint64_t) (1E9 * w->secs);
+    w->n = 0;
+    w->cyc = 0;
+    do {
+        t = bench_ns();
+        cc = plat_get_cycle();
+        worker_op(w);
+        cc = plat_get_cycle() - cc;
+        w->t1 = bench_ns();
+        w->lat[w->n] = w->t1 - t;
+        if (w->att != NULL) {
+            racc_sign_stat(&sst, false);
+            i = sst.last_bound + sst.last_enc + 1;
+            w->att[w->n] = i < RACC_STAT_HIST ? i : RACC_STAT_HIST;
+        }
+        w->n++;
+        w->cyc += cc;
+    } while (w->t1 < t_end && w->n < w->max_n);
+
+    memset(ev1, 0, sizeof(ev1));
+    if (w->perf)
+        bench_perf_read(&w->pf, ev1);
+    for (i = 0; i < BENCH_PERF_NUM; i++) {
+        w->ev[i] = ev1[i] - ev0[i];
+    }
+
+#ifdef RACC_PROFILE
+    w->prof = racc_prof;
+    racc_prof.ev_read = NULL;
+    bench_perf_thread(NULL);
+#endif
+    if (w->perf)
+        bench_perf_close(&w->pf);
+    racc_sign_stat(&w->stat, true);
+    nist_randombytes_ctx(NULL);
+    worker_free(w);
+
+    return NULL;
+}
+
+//  print the distribution of signing attempts, with the latencies of
+//  signatures that took each number of attempts ("lat", "att": "m" samples)
+
+static void print_attempts(const racc_sign_stat_t *st,
+                           const uint64_t *lat, const uint8_t *att, size_t m)
+{
+    size_t i, j, k, imax;
+    uint64_t hmax, *v;
+    bench_stat_t bs;
+    double n;
+
+    if (st->sig == 0)
+        return;
+    n = (double) st->sig;
+
+    imax = 0;
+    hmax = 0;
+    for (i = 0; i < RACC_STAT_HIST; i++) {
+        if (st->hist[i] > 0)
+            imax = i;
+        if (st->hist[i] > hmax)
+            hmax = st->hist[i];
+    }
+
+    printf("%s	attempts/sig= %.4f  CheckBounds fail/sig= %.4f  "
+           "encoding fail/sig= %.4f\n", CRYPTO_ALGNAME,
+           ((double) (st->sig + st->bound_fail + st->enc_fail)) / n,
+           ((double) st->bound_fail) / n, ((double) st->enc_fail) / n);
+
+    v = calloc(m + 1, sizeof(uint64_t));
+    if (v == NULL) {
+        perror("calloc()");
+        exit(1);
+    }
+
+    for (i = 0; i <= imax; i++) {
+        k = 0;
+        for (j = 0; j < m; j++) {
+            if (att[j] == i + 1)
+                v[k++] = lat[j];
+        }
+        bench_stat(&bs, v, k);
+        printf("  %2zu%s %10llu %8.4f%%  p50=%8.3f p90=%8.3f p99=%8.3f ms  ",
+               i + 1, i == RACC_STAT_HIST - 1 ? "+" : " ",
+               (unsigned long long) st->hist[i],
+               100.0 * ((double) st->hist[i]) / n,
+               1E-6 * bs.p50, 1E-6 * bs.p90, 1E-6 * bs.p99);
+        bench_bar((double) st->hist[i], (double) hmax, 50);
+        printf("\n");
+    }
+    free(v);
+}
+
+//  print hardware events per operation
+
+static void print_perf(int op, int nthr, const uint64_t ev[BENCH_PERF_NUM],
+                       const bool ok[BENCH_PERF_NUM], double n)
+{
+    int i;
+
+    printf("%s\t%6s() thr=%3d:\t", CRYPTO_ALGNAME, op_name[op], nthr);
+    for (i = 0; i < BENCH_PERF_NUM; i++) {
+        if (ok[i]) {
+            printf(" %s=%.1fk", bench_perf_name[i],
+                   1E-3 * ((double) ev[i]) / n);
+        } else {
+            printf(" %s=n/a", bench_perf_name[i]);
+        }
+    }
+    if (ok[BENCH_PERF_INSTR] && ok[BENCH_PERF_CYCLES] &&
+        ev[BENCH_PERF_CYCLES] > 0) {
+        printf(" IPC=%.2f", ((double) ev[BENCH_PERF_INSTR]) /
+                            ((double) ev[BENCH_PERF_CYCLES]));
+    }
+    printf(" (per op)\n");
+}
+
+#ifdef RACC_PROFILE
+
+//  print hardware events of each instrumented phase, per operation
+
+static void print_prof_perf(const racc_prof_t *pr,
+                            const bool ok[BENCH_PERF_NUM])
+{
+    int i, j;
+    double ops;
+    const uint64_t *ev;
+
+    printf("%-18s", "phase (k/op)");
+    for (j = 0; j < BENCH_PERF_NUM; j++) {
+        printf(" %10s", bench_perf_name[j]);
+    }
+    printf(" %6s\n", "IPC");
+
+    ops = 1.0;
+    for (i = 0; i < RACC_PROF_NUM; i++) {
+
+        //  skip operations that were not run
+        if (i == RACC_PROF_KG_ALL || i == RACC_PROF_SG_ALL ||
+            i == RACC_PROF_VF_ALL) {
+            if (pr->cnt[i] == 0) {
+                while (i + 1 < RACC_PROF_NUM &&
+                       racc_prof_name[i + 1][0] == ' ') {
+                    i++;
+                }
+                continue;
+            }
+            ops = (double) pr->cnt[i];
+        }
+
+        ev = pr->ev[i];
+        printf("%-18s", racc_prof_name[i]);
+        for (j = 0; j < BENCH_PERF_NUM; j++) {
+            if (ok[j]) {
+                printf(" %10.1f", 1E-3 * ((double) ev[j]) / ops);
+            } else {
+                printf(" %10s", "n/a");
+            }
+        }
+        if (ok[BENCH_PERF_INSTR] && ok[BENCH_PERF_CYCLES] &&
+            ev[BENCH_PERF_CYCLES] > 0) {
+            printf(" %6.2f", ((double) ev[BENCH_PERF_INSTR]) /
+                             ((double) ev[BENCH_PERF_CYCLES]));
+        }
+        printf("\n");
+    }
+}
+
+//  RACC_PROFILE
+#endif
+
+//  run "op" on "nthr" threads; return throughput (ops/sec)
+
+static double bench_run(int op, int nthr, double base, const bench_opt_t *opt,
+                        bench_rec_t *rec)
+{
+    size_t k;
+    int i;
+    size_t j, n;
+    worker_t *w;
+    pthread_barrier_t bar;
+    pthread_attr_t attr;
+    uint64_t t0, t1, cyc, *lat, *alat;
+    uint8_t *att;
+    double ops;
+    bench_stat_t st;
+    racc_prof_t pr;
+    racc_sign_stat_t sst;
+    uint64_t ev[BENCH_PERF_NUM];
+    bool ev_ok[BENCH_PERF_NUM];
+
+    w = calloc(nthr, sizeof(worker_t));
+    if (w == NULL) {
+        perror("calloc()");
+        exit(1);
+    }
+
+    //  big stack frames in racc_core_sign() at high d
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 16 << 20);
+    pthread_barrier_init(&bar, NULL, nthr);
+
+    for (i = 0; i < nthr; i++) {
+        w[i].bar = &bar;
+        w[i].id = i;
+        w[i].op = op;
+        w[i].secs = opt->secs;
+        w[i].max_n = opt->max_n;
+        w[i].perf = opt->perf;
+        w[i].res = opt->res;
+        w[i].mlen = opt->mlen;
+        w[i].lat = calloc(opt->max_n, sizeof(uint64_t));
+        if (opt->attempts && op == OP_SIGN)
+            w[i].att = calloc(opt->max_n, 1);
+        if (w[i].lat == NULL ||
+            (opt->attempts && op == OP_SIGN && w[i].att == NULL)) {
+            perror("calloc()");
+            exit(1);
+        }
+        if (pthread_create(&w[i].th, &attr, worker_main, &w[i]) != 0) {
+            perror("pthread_create()");
+            exit(1);
+        }
+    }
+
+    //  collect
+    memset(&pr, 0, sizeof(pr));
+    memset(&sst, 0, sizeof(sst));
+    memset(ev, 0, sizeof(ev));
+    for (k = 0; k < BENCH_PERF_NUM; k++) {
+        ev_ok[k] = opt->perf;
+    }
+    n = 0;
+    cyc = 0;
+    t0 = UINT64_MAX;
+    t1 = 0;
+    for (i = 0; i < nthr; i++) {
+        pthread_join(w[i].th, NULL);
+#ifdef RACC_PROFILE
+        racc_prof_add(&pr, &w[i].prof);
+#endif
+        sst.sig += w[i].stat.sig;
+        sst.bound_fail += w[i].stat.bound_fail;
+        sst.enc_fail += w[i].stat.enc_fail;
+        for (k = 0; k < RACC_STAT_HIST; k++) {
+            sst.hist[k] += w[i].stat.hist[k];
+        }
+        for (k = 0; k < BENCH_PERF_NUM; k++) {
+            ev[k] += w[i].ev[k];
+            ev_ok[k] = ev_ok[k] && w[i].ev_ok[k];
+        }
+        n += w[i].n;
+        cyc += w[i].cyc;
+        if (w[i].t0 < t0)
+            t0 = w[i].t0;
+        if (w[i].t1 > t1)
+            t1 = w[i].t1;
+        if (w[i].fail > 0) {
+            printf("%s\tworker %d: %d verification failures!\n",
+                    CRYPTO_ALGNAME, i, w[i].fail);
+        }
+    }
+
+    lat = calloc(n, sizeof(uint64_t));
+    alat = calloc(n, sizeof(uint64_t));
+    att = calloc(n, 1);
+    if (lat == NULL || alat == NULL || att == NULL) {
+        perror("calloc()");
+        exit(1);
+    }
+    n = 0;
+    for (i = 0; i < nthr; i++) {
+        for (j = 0; j < w[i].n; j++) {
+            if (w[i].att != NULL)
+                att[n] = w[i].att[j];
+            lat[n++] = w[i].lat[j];
+        }
+        free(w[i].lat);
+        free(w[i].att);
+    }
+    memcpy(alat, lat, n * sizeof(uint64_t));    //  (bench_stat sorts lat)
+
+    bench_stat(&st, lat, n);
+    ops = 1E9 * ((double) n) / ((double) (t1 - t0));
+    if (base <= 0.0)
+        base = ops;
+
+    memset(rec, 0, sizeof(bench_rec_t));
+    snprintf(rec->param, sizeof(rec->param), "%s", CRYPTO_ALGNAME);
+    snprintf(rec->op, sizeof(rec->op), "%s", op_name[op]);
+    rec->thr = nthr;
+    rec->n = n;
+    rec->ns = st.avg;
+    rec->sd = st.sd;
+    rec->cyc = ((double) cyc) / ((double) n);
+
+    if (opt->fmt == FMT_TEXT) {
+        printf("%s\t%6s() thr=%3d:\t%10.1f op/s  x%5.2f  %8.3f Mcyc"
+               "  p50=%8.3f p90=%8.3f p99=%8.3f p99.9=%8.3f max=%8.3f ms\n",
+               CRYPTO_ALGNAME, op_name[op], nthr, ops, ops / base,
+               1E-6 * rec->cyc,
+               1E-6 * st.p50, 1E-6 * st.p90, 1E-6 * st.p99, 1E-6 * st.p999,
+               1E-6 * st.max);
+    }
+
+    if (opt->perf) {
+        print_perf(op, nthr, ev, ev_ok, (double) n);
+    }
+
+    if (opt->histo) {
+        bench_histo(lat, n, 1E6, "ms");
+    }
+
+    if (opt->attempts && op == OP_SIGN) {
+        print_attempts(&sst, alat, att, n);
+    }
+
+#ifdef RACC_PROFILE
+    if (opt->prof) {
+        racc_prof_print(&pr);
+        if (opt->perf) {
+            print_prof_perf(&pr, ev_ok);
+        }
+    }
+#else
+    (void) pr;
+#endif
+
+    free(lat);
+    free(alat);
+    free(att);
+    free(w);
+    pthread_barrier_destroy(&bar);
+    pthread_attr_destroy(&attr);
+
+    return ops;
+}
+
+//  build options that affect performance
+
+static const char *bench_backend()
+{
+    static char buf[64];
+    static const char *aes[] = { "+aes1kt", "+aesni", "+vaes" };
+
+    snprintf(buf, sizeof(buf), "%s%s",
+#ifdef POLYR_Q32
+        "ntt32"
+#else
+        "ntt64"
+#endif
+#ifdef MASK_RANDOM_ASCON
+        "+ascon"
+#else
+        "+lfsr127"
+#endif
+#ifdef RACC_SIGN_SPEC
+        "+spec"
+#endif
+#ifdef RACC_PROFILE
+        "+prof"
+#endif
+        , aes[aesni_level()]);
+
+    return buf;
+}
+
+//  peak stack usage of one "op"
+
+static void *stack_main(void *arg)
+{
+    worker_op((worker_t *) arg);
+    return NULL;
+}
+
+static size_t op_stack(int op, size_t mlen)
+{
+    size_t sz;
+    worker_t *w;
+
+    w = calloc(1, sizeof(worker_t));
+    if (w == NULL) {
+        perror("calloc()");
+        exit(1);
+    }
+    w->op = op;
+    w->mlen = mlen;
+    worker_init(w);
+    sz = bench_stack(stack_main, w, 16 << 20);
+    worker_free(w);
+    free(w);
+
+    return sz;
+}
+
+//  print a record as CSV or JSON
+
+static void rec_print(const bench_rec_t *r, int fmt)
+{
+    if (fmt == FMT_CSV) {
+        printf("%s,%s,%d,%zu,%.1f,%.1f,%.1f,%zu,%s\n",
+               r->param, r->op, r->thr, r->n, r->ns, r->sd, r->cyc,
+               r->stack, r->backend);
+    } else if (fmt == FMT_JSON) {
+        printf("{\"param\":\"%s\",\"op\":\"%s\",\"threads\":%d,"
+               "\"iterations\":%zu,\"ns_op\":%.1f,\"sd_ns\":%.1f,"
+               "\"cycles_op\":%.1f,\"stack\":%zu,\"backend\":\"%s\"}\n",
+               r->param, r->op, r->thr, r->n, r->ns, r->sd, r->cyc,
+               r->stack, r->backend);
+    }
+    fflush(stdout);
+}
+
+//  load baseline records (CSV or JSON lines as written by rec_print)
+
+static bench_rec_t *rec_load(const char *fn, size_t *n)
+{
+    FILE *f;
+    char buf[512];
+    bench_rec_t *b, r;
+    int k;
+
+    f = fopen(fn, "r");
+    if (f == NULL) {
+        perror(fn);
+        return NULL;
+    }
+    b = calloc(MAX_BASE, sizeof(bench_rec_t));
+    if (b == NULL) {
+        perror("calloc()");
+        exit(1);
+    }
+
+    *n = 0;
+    while (*n < MAX_BASE && fgets(buf, sizeof(buf), f) != NULL) {
+        memset(&r, 0, sizeof(r));
+        if (buf[0] == '{') {
+            k = sscanf(buf, "{\"param\":\"%31[^\"]\",\"op\":\"%15[^\"]\","
+                       "\"threads\":%d,\"iterations\":%zu,\"ns_op\":%lf,"
+                       "\"sd_ns\":%lf,\"cycles_op\":%lf,\"stack\":%zu,"
+                       "\"backend\":\"%63[^\"]\"}",
+                       r.param, r.op, &r.thr, &r.n, &r.ns, &r.sd, &r.cyc,
+                       &r.stack, r.backend);
+        } else {
+            k = sscanf(buf, "%31[^,],%15[^,],%d,%zu,%lf,%lf,%lf,%zu,"
+                       "%63[^,\r\n]",
+                       r.param, r.op, &r.thr, &r.n, &r.ns, &r.sd, &r.cyc,
+                       &r.stack, r.backend);
+        }
+        if (k >= 8 && r.ns > 0.0)                //  skips the CSV header
+            b[(*n)++] = r;
+    }
+    fclose(f);
+
+    return b;
+}
+
+//  compare "r" with the baseline; return true if it is a regression
+
+static bool rec_compare(const bench_rec_t *r, const bench_opt_t *opt)
+{
+    size_t i;
+    const bench_rec_t *b;
+    double d, t;
+    bool has_t, sig, reg;
+    const char *res;
+    FILE *out;
+
+    //  text goes to stdout unless that carries records
+    out = opt->fmt == FMT_TEXT ? stdout : stderr;
+
+    b = NULL;
+    for (i = 0; i < opt->base_n; i++) {
+        if (strcmp(opt->base[i].param, r->param) == 0 &&
+            strcmp(opt->base[i].op, r->op) == 0 &&
+            opt->base[i].thr == r->thr) {
+            b = &opt->base[i];
+            break;
+        }
+    }
+    if (b == NULL) {
+        fprintf(out, "%s\t%6s() thr=%3d:\tno baseline\n",
+                r->param, r->op, r->thr);
+        return false;
+    }
+
+    //  relative change of mean latency
+    d = r->ns / b->ns - 1.0;
+
+    //  Welch's t if both sides have a deviation, else tolerance only
+    t = 0.0;
+    sig = true;
+    has_t = b->sd > 0.0 && b->n > 1 && r->n > 1;
+    if (has_t) {
+        t = (r->ns - b->ns) / sqrt(r->sd * r->sd / ((double) r->n) +
+                                   b->sd * b->sd / ((double) b->n));
+        sig = fabs(t) > SIG_T;
+    }
+
+    reg = sig && d > opt->tol;
+    if (reg) {
+        res = "REGRESSION";
+    } else if (sig && d < -opt->tol) {
+        res = "faster";
+    } else {
+        res = "ok";
+    }
+
+    fprintf(out, "%s\t%6s() thr=%3d:\t%12.0f ns vs %12.0f ns  %+7.2f%%  ",
+            r->param, r->op, r->thr, r->ns, b->ns, 100.0 * d);
+    if (has_t) {
+        fprintf(out, "t=%7.2f  %s\n", t, res);
+    } else {
+        fprintf(out, "t=    n/a  %s\n", res);
+    }
+
+    return reg;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-t max_threads] [-s seconds] [-n max_samples] "
+           "[-o op] [-m bytes] [-H] [-p] [-a] [-P] [-R]\n"
+           "       [-f text|csv|json] [-c baseline] [-T percent]\n"
+           "  -t  highest thread count (default: nproc); runs 1, 2, 4, ..\n"
+           "  -s  measurement time per thread count (default: 1.0 s)\n"
+           "  -n  maximum samples per thread (default: 65536)\n"
+           "  -o  a single operation: keygen, sign, verify, verifypipe\n"
+           "      (default: all)\n"
+           "  -m  message size in bytes (default: 3)\n"
+           "  -H  print latency histograms\n"
+           "  -p  print per-phase profile (build with -DRACC_PROFILE)\n"
+           "  -a  print the distribution of signing attempts, with\n"
+           "      latencies per number of attempts\n"
+           "  -P  hardware event counters (Linux perf_event_open)\n"
+           "  -R  buffered randombytes() (not the NIST DRBG stream)\n"
+           "  -f  output format; csv and json print one record per run\n"
+           "  -c  compare with baseline records (csv or json); exit code\n"
+           "      3 if an operation is significantly slower\n"
+           "  -T  regression tolerance in percent (default: 5)\n",
+           prog);
+}
+
+int main(int argc, char **argv)
+{
+    int c, op, op0, op1, nthr, max_thr;
+    double base, ops;
+    bench_opt_t opt;
+    bench_rec_t rec;
+    size_t stack;
+    const char *base_fn;
+    bool reg;
+
+    memset(&opt, 0, sizeof(opt));
+    max_thr = bench_nproc();
+    opt.max_n = 1 << 16;
+    opt.mlen = DEF_MSG;
+    opt.fmt = FMT_TEXT;
+    opt.tol = 0.05;
+    base_fn = NULL;
+    reg = false;
+    op0 = 0;
+    op1 = OP_NUM - 1;
+
+#ifdef BENCH_TIMEOUT
+    opt.secs = BENCH_TIMEOUT;
+#else
+    opt.secs = 1.0;
+#endif
+
+    while ((c = getopt(argc, argv, "t:s:n:o:m:HpaPRf:c:T:h")) != -1) {
+        switch (c) {
+            case 't':
+                max_thr = atoi(optarg);
+                break;
+            case 's':
+                opt.secs = atof(optarg);
+                break;
+            case 'n':
+                opt.max_n = (size_t) atol(optarg);
+                break;
+            case 'o':
+                for (op = 0; op < OP_NUM; op++) {
+                    if (strcasecmp(optarg, op_name[op]) == 0)
+                        break;
+                }
+                if (op == OP_NUM) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                op0 = op1 = op;
+                break;
+            case 'm':
+                opt.mlen = (size_t) atol(optarg);
+                break;
+            case 'H':
+                opt.histo = true;
+                break;
+            case 'p':
+#ifndef RACC_PROFILE
+                printf("%s: -p needs a RACC_PROFILE build.\n", argv[0]);
+                return 1;
+#endif
+                opt.prof = true;
+                break;
+            case 'a':
+                opt.attempts = true;
+                break;
+            case 'P':
+                opt.perf = true;
+                break;
+            case 'R':
+                opt.res = true;
+                break;
+            case 'f':
+                if (strcasecmp(optarg, "text") == 0) {
+                    opt.fmt = FMT_TEXT;
+                } else if (strcasecmp(optarg, "csv") == 0) {
+                    opt.fmt = FMT_CSV;
+                } else if (strcasecmp(optarg, "json") == 0) {
+                    opt.fmt = FMT_JSON;
+                } else {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'c':
+                base_fn = optarg;
+                break;
+            case 'T':
+                opt.tol = 0.01 * atof(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (max_thr < 1 || opt.max_n < 1 || opt.secs <= 0.0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (base_fn != NULL) {
+        opt.base = rec_load(base_fn, &opt.base_n);
+        if (opt.base == NULL)
+            return 1;
+    }
+
+    if (opt.fmt == FMT_TEXT) {
+        printf("=== xbench %s (nproc=%d) ===\n",
+               CRYPTO_ALGNAME, bench_nproc());
+    } else if (opt.fmt == FMT_CSV) {
+        printf("param,op,threads,iterations,ns_op,sd_ns,cycles_op,"
+               "stack,backend\n");
+    }
+
+    for (op = op0; op <= op1; op++) {
+        stack = op_stack(op, opt.mlen);
+        if (opt.fmt == FMT_TEXT) {
+            printf("%s\t%6s() stack= %zu bytes\n",
+                   CRYPTO_ALGNAME, op_name[op], stack);
+        }
+        base = 0.0;
+        nthr = 1;
+        for (;;) {
+            ops = bench_run(op, nthr, base, &opt, &rec);
+            rec.stack = stack;
+            snprintf(rec.backend, sizeof(rec.backend), "%.56s%s",
+                     bench_backend(), opt.res ? "+res" : "");
+            rec_print(&rec, opt.fmt);
+            if (opt.base != NULL && rec_compare(&rec, &opt))
+                reg = true;
+            if (base <= 0.0)
+                base = ops;
+            if (nthr >= max_thr)
+                break;
+            nthr *= 2;
+            if (nthr > max_thr)
+                nthr = max_thr;
+        }
+    }
+
+    free(opt.base);
+
+    return reg ? 3 : 0;
+}
+
+// NIST_KAT
+#endif
@@ -0,0 +1,174 @@
+//  bench_perf.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Hardware event counters via Linux perf_event_open(2).
+
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "plat_local.h"
+#include "bench_perf.h"
+
+//  short event names
+
+const char *bench_perf_name[BENCH_PERF_NUM] = {
+    "instr", "cycles", "L1d-miss", "LLC-miss", "br-miss"
+};
+
+//  counters of the calling thread for the profiler hook
+
+static PLAT_TLS const bench_perf_t *perf_thread = NULL;
+
+#ifdef __linux__
+
+//  (type, config) of each event
+
+static const uint32_t perf_type[BENCH_PERF_NUM] = {
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+};
+
+static const uint64_t perf_config[BENCH_PERF_NUM] = {
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_CACHE_L1D |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+//  open and start counters for the calling thread
+
+int bench_perf_open(bench_perf_t *pf)
+{
+    int i, fd;
+    struct perf_event_attr pa;
+
+    pf->lead = -1;
+    pf->nfd = 0;
+
+    for (i = 0; i < BENCH_PERF_NUM; i++) {
+        pf->fd[i] = -1;
+        pf->slot[i] = -1;
+
+        memset(&pa, 0, sizeof(pa));
+        pa.size = sizeof(pa);
+        pa.type = perf_type[i];
+        pa.config = perf_config[i];
+        pa.read_format = PERF_FORMAT_GROUP;
+        pa.disabled = pf->lead < 0 ? 1 : 0;
+        pa.exclude_kernel = 1;
+        pa.exclude_hv = 1;
+
+        //  this thread, any cpu; all events in one group
+        fd = (int) syscall(SYS_perf_event_open, &pa, 0, -1, pf->lead, 0);
+        if (fd < 0)
+            continue;
+        if (pf->lead < 0)
+            pf->lead = fd;
+        pf->fd[i] = fd;
+        pf->slot[i] = pf->nfd++;
+    }
+
+    if (pf->lead >= 0) {
+        ioctl(pf->lead, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(pf->lead, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    return pf->nfd;
+}
+
+//  current counts (unavailable events read as 0)
+
+void bench_perf_read(const bench_perf_t *pf, uint64_t v[BENCH_PERF_NUM])
+{
+    int i;
+    uint64_t buf[1 + BENCH_PERF_NUM];
+
+    memset(buf, 0, sizeof(buf));
+    if (pf->lead >= 0) {
+        //  { nr, value[nr] }
+        if (read(pf->lead, buf, sizeof(buf)) < 0)
+            memset(buf, 0, sizeof(buf));
+    }
+    for (i = 0; i < BENCH_PERF_NUM; i++) {
+        v[i] = pf->slot[i] >= 0 ? buf[1 + pf->slot[i]] : 0;
+    }
+}
+
+//  stop and close counters
+
+void bench_perf_close(bench_perf_t *pf)
+{
+    int i;
+
+    if (pf->lead >= 0)
+        ioctl(pf->lead, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    //  members before the leader
+    for (i = BENCH_PERF_NUM - 1; i >= 0; i--) {
+        if (pf->fd[i] >= 0)
+            close(pf->fd[i]);
+        pf->fd[i] = -1;
+        pf->slot[i] = -1;
+    }
+    pf->lead = -1;
+    pf->nfd = 0;
+}
+
+#else
+
+//  not Linux: no counters
+
+int bench_perf_open(bench_perf_t *pf)
+{
+    int i;
+
+    for (i = 0; i < BENCH_PERF_NUM; i++) {
+        pf->fd[i] = -1;
+        pf->slot[i] = -1;
+    }
+    pf->lead = -1;
+    pf->nfd = 0;
+
+    return 0;
+}
+
+void bench_perf_read(const bench_perf_t *pf, uint64_t v[BENCH_PERF_NUM])
+{
+    (void) pf;
+    memset(v, 0, BENCH_PERF_NUM * sizeof(uint64_t));
+}
+
+void bench_perf_close(bench_perf_t *pf)
+{
+    (void) pf;
+}
+
+//  __linux__
+#endif
+
+//  make "pf" the source for bench_perf_thread_read() in the calling thread
+
+void bench_perf_thread(const bench_perf_t *pf)
+{
+    perf_thread = pf;
+}
+
+//  read the counters set with bench_perf_thread() (racc_prof hook)
+
+void bench_perf_thread_read(uint64_t *v)
+{
+    if (perf_thread != NULL) {
+        bench_perf_read(perf_thread, v);
+    } else {
+        memset(v, 0, BENCH_PERF_NUM * sizeof(uint64_t));
+    }
+}
@@ -0,0 +1,58 @@
+//  bench_perf.h
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Hardware event counters via Linux perf_event_open(2).
+
+#ifndef _BENCH_PERF_H_
+#define _BENCH_PERF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//  counted events
+enum {
+    BENCH_PERF_INSTR,                       //  instructions retired
+    BENCH_PERF_CYCLES,                      //  core clock cycles
+    BENCH_PERF_L1D_MISS,                    //  L1 data cache read misses
+    BENCH_PERF_LLC_MISS,                    //  last-level cache misses
+    BENCH_PERF_BR_MISS,                     //  mispredicted branches
+    BENCH_PERF_NUM
+};
+
+//  short event names
+extern const char *bench_perf_name[BENCH_PERF_NUM];
+
+//  counters of one thread
+typedef struct {
+    int fd[BENCH_PERF_NUM];                 //  -1 if not available
+    int slot[BENCH_PERF_NUM];               //  position in group read
+    int lead;                               //  group leader fd
+    int nfd;                                //  number of open counters
+} bench_perf_t;
+
+//  open and start counters for the calling thread; return number of
+//  available events (0 if perf_event_open is not supported)
+int bench_perf_open(bench_perf_t *pf);
+
+//  current counts (unavailable events read as 0)
+void bench_perf_read(const bench_perf_t *pf, uint64_t v[BENCH_PERF_NUM]);
+
+//  stop and close counters
+void bench_perf_close(bench_perf_t *pf);
+
+//  make "pf" the source for bench_perf_thread_read() in the calling thread
+void bench_perf_thread(const bench_perf_t *pf);
+
+//  read the counters set with bench_perf_thread() (racc_prof hook)
+void bench_perf_thread_read(uint64_t *v);
+
+#ifdef __cplusplus
+}
+#endif
+
+//  _BENCH_PERF_H_
+#endif
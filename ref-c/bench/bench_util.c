@@ -0,0 +1,213 @@
+//  bench_util.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Shared helpers for the benchmark tools (timing, statistics).
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <pthread.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "bench_util.h"
+
+//  monotonic wall-clock time in nanoseconds
+
+uint64_t bench_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec) * 1000000000llu + ((uint64_t) ts.tv_nsec);
+}
+
+//  number of online processors (at least 1)
+
+int bench_nproc()
+{
+    long n;
+
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : (int) n;
+}
+
+//  pin the calling thread to processor "cpu"; return 0 on success
+
+int bench_pin_cpu(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu % bench_nproc(), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void) cpu;
+    return -1;
+#endif
+}
+
+//  comparison for qsort()
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *((const uint64_t *) a);
+    uint64_t y = *((const uint64_t *) b);
+
+    return (x > y) - (x < y);
+}
+
+//  nearest-rank percentile of sorted "v"
+
+static double pctl(const uint64_t *v, size_t n, double p)
+{
+    size_t i;
+
+    i = (size_t) ceil(p * ((double) n));
+    if (i > 0)
+        i--;
+    if (i >= n)
+        i = n - 1;
+    return (double) v[i];
+}
+
+//  compute statistics of "n" samples "v" (the array is sorted in place)
+
+void bench_stat(bench_stat_t *st, uint64_t *v, size_t n)
+{
+    size_t i;
+    double x, s, ss;
+
+    memset(st, 0, sizeof(bench_stat_t));
+    if (n == 0)
+        return;
+
+    qsort(v, n, sizeof(uint64_t), cmp_u64);
+
+    s = 0.0;
+    for (i = 0; i < n; i++) {
+        s += (double) v[i];
+    }
+    st->avg = s / ((double) n);
+
+    ss = 0.0;
+    for (i = 0; i < n; i++) {
+        x = ((double) v[i]) - st->avg;
+        ss += x * x;
+    }
+    st->sd = n > 1 ? sqrt(ss / ((double) (n - 1))) : 0.0;
+
+    st->n = n;
+    st->min = (double) v[0];
+    st->max = (double) v[n - 1];
+    st->p50 = pctl(v, n, 0.50);
+    st->p90 = pctl(v, n, 0.90);
+    st->p99 = pctl(v, n, 0.99);
+    st->p999 = pctl(v, n, 0.999);
+}
+
+//  run "fn(arg)" in a thread with a painted stack of "max_sz" bytes;
+//  return the peak stack usage in bytes (0 on error)
+
+#define STACK_PAINT 0xA5
+
+size_t bench_stack(void *(*fn)(void *), void *arg, size_t max_sz)
+{
+    size_t i;
+    void *stk;
+    uint8_t *p;
+    pthread_t th;
+    pthread_attr_t attr;
+
+    if (posix_memalign(&stk, 4096, max_sz) != 0)
+        return 0;
+    memset(stk, STACK_PAINT, max_sz);
+
+    pthread_attr_init(&attr);
+    if (pthread_attr_setstack(&attr, stk, max_sz) != 0 ||
+        pthread_create(&th, &attr, fn, arg) != 0) {
+        pthread_attr_destroy(&attr);
+        free(stk);
+        return 0;
+    }
+    pthread_join(th, NULL);
+    pthread_attr_destroy(&attr);
+
+    //  the stack grows down: find the lowest overwritten byte
+    p = (uint8_t *) stk;
+    for (i = 0; i < max_sz && p[i] == STACK_PAINT; i++)
+        ;
+    free(stk);
+
+    return max_sz - i;
+}
+
+//  print a horizontal bar of length proportional to "x / x_max"
+
+void bench_bar(double x, double x_max, int width)
+{
+    int i, l;
+
+    l = x_max > 0.0 ? (int) ((x / x_max) * ((double) width) + 0.5) : 0;
+    if (x > 0.0 && l == 0)
+        l = 1;
+    for (i = 0; i < l; i++) {
+        putchar('#');
+    }
+}
+
+//  quarter-octave bucket of value x > 0
+
+static int histo_bucket(uint64_t x)
+{
+    return (int) floor(4.0 * log2((double) (x > 0 ? x : 1)));
+}
+
+//  print a log2-bucketed histogram of sorted samples "v", scaled by "unit"
+
+void bench_histo(const uint64_t *v, size_t n, double unit, const char *lab)
+{
+    size_t i, cnt, cmax;
+    int b, b0, b1;
+
+    if (n == 0)
+        return;
+
+    b0 = histo_bucket(v[0]);
+    b1 = histo_bucket(v[n - 1]);
+
+    //  find the largest bucket for scaling
+    cmax = 0;
+    cnt = 0;
+    b = b0;
+    for (i = 0; i < n; i++) {
+        if (histo_bucket(v[i]) != b) {
+            b = histo_bucket(v[i]);
+            cnt = 0;
+        }
+        cnt++;
+        if (cnt > cmax)
+            cmax = cnt;
+    }
+
+    i = 0;
+    for (b = b0; b <= b1; b++) {
+        cnt = 0;
+        while (i < n && histo_bucket(v[i]) == b) {
+            cnt++;
+            i++;
+        }
+        printf("  %10.3f %s %8zu  ", exp2(0.25 * b) / unit, lab, cnt);
+        bench_bar((double) cnt, (double) cmax, 50);
+        printf("\n");
+    }
+}
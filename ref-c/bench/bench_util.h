@@ -0,0 +1,52 @@
+//  bench_util.h
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Shared helpers for the benchmark tools (timing, statistics).
+
+#ifndef _BENCH_UTIL_H_
+#define _BENCH_UTIL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//  summary statistics of a set of samples
+typedef struct {
+    size_t n;                               //  number of samples
+    double min, max;                        //  range
+    double avg, sd;                         //  mean and standard deviation
+    double p50, p90, p99, p999;             //  percentiles
+} bench_stat_t;
+
+//  monotonic wall-clock time in nanoseconds
+uint64_t bench_ns();
+
+//  number of online processors (at least 1)
+int bench_nproc();
+
+//  pin the calling thread to processor "cpu"; return 0 on success
+int bench_pin_cpu(int cpu);
+
+//  compute statistics of "n" samples "v" (the array is sorted in place)
+void bench_stat(bench_stat_t *st, uint64_t *v, size_t n);
+
+//  print a log2-bucketed histogram of sorted samples "v", scaled by "unit"
+void bench_histo(const uint64_t *v, size_t n, double unit, const char *lab);
+
+//  run "fn(arg)" in a thread with a painted stack of "max_sz" bytes;
+//  return the peak stack usage in bytes (0 on error)
+size_t bench_stack(void *(*fn)(void *), void *arg, size_t max_sz);
+
+//  print a horizontal bar of length proportional to "x / x_max"
+void bench_bar(double x, double x_max, int width);
+
+#ifdef __cplusplus
+}
+#endif
+
+//  _BENCH_UTIL_H_
+#endif
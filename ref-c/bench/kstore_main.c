@@ -0,0 +1,221 @@
+//  kstore_main.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Precomputed key store tool (xkstore).
+
+#ifndef NIST_KAT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "plat_local.h"
+#include "bench_util.h"
+#include "racc_core.h"
+#include "racc_serial.h"
+#include "racc_kstore.h"
+#include "api.h"
+
+//  read a file of concatenated encoded public keys; return the count
+
+static size_t read_keys(uint8_t **pk, const char *fn)
+{
+    FILE *f;
+    long sz;
+    size_t n;
+
+    *pk = NULL;
+    f = fopen(fn, "rb");
+    if (f == NULL) {
+        perror(fn);
+        return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    n = sz > 0 ? (size_t) sz / CRYPTO_PUBLICKEYBYTES : 0;
+    if (n * CRYPTO_PUBLICKEYBYTES != (size_t) sz) {
+        fprintf(stderr, "%s: not a multiple of %d bytes\n",
+                fn, CRYPTO_PUBLICKEYBYTES);
+        n = 0;
+    }
+    if (n > 0) {
+        *pk = malloc(n * CRYPTO_PUBLICKEYBYTES);
+        if (*pk == NULL ||
+            fread(*pk, CRYPTO_PUBLICKEYBYTES, n, f) != n) {
+            perror(fn);
+            free(*pk);
+            *pk = NULL;
+            n = 0;
+        }
+    }
+    fclose(f);
+
+    return n;
+}
+
+//  -g: write "n" fresh public keys to "fn"
+
+static int gen_keys(const char *fn, size_t n)
+{
+    size_t i;
+    FILE *f;
+    uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+    uint8_t sk[CRYPTO_SECRETKEYBYTES];
+
+    f = fopen(fn, "wb");
+    if (f == NULL) {
+        perror(fn);
+        return 1;
+    }
+    for (i = 0; i < n; i++) {
+        crypto_sign_keypair(pk, sk);
+        if (fwrite(pk, CRYPTO_PUBLICKEYBYTES, 1, f) != 1) {
+            perror(fn);
+            fclose(f);
+            return 1;
+        }
+    }
+    fclose(f);
+    printf("%s: %zu %s public keys\n", fn, n, CRYPTO_ALGNAME);
+
+    return 0;
+}
+
+//  -c: check a store and compare a lookup with decoding (and expanding)
+
+static int check_store(const char *fn, const char *keys)
+{
+    size_t i, n, miss;
+    uint64_t t0, t1, t2;
+    uint8_t *pk;
+    racc_kstore_t ks;
+    racc_pk_t r_pk;
+    static int64_t a[RACC_K][RACC_ELL][RACC_N];
+
+    t0 = bench_ns();
+    if (racc_kstore_open(&ks, fn, false) != 0) {
+        fprintf(stderr, "%s: not a valid %s store\n", fn, CRYPTO_ALGNAME);
+        return 1;
+    }
+    t1 = bench_ns();
+    racc_kstore_close(&ks);
+    if (racc_kstore_open(&ks, fn, true) != 0) {
+        fprintf(stderr, "%s: checksum mismatch\n", fn);
+        return 1;
+    }
+    t2 = bench_ns();
+
+    printf("%s: %s v%u, %zu keys, %zu bytes/key%s, %zu bytes\n",
+           fn, ks.hdr->name, ks.hdr->version, ks.n, ks.stride,
+           ks.a_off != 0 ? " (with A)" : "", ks.map_sz);
+    printf("open: %.3f ms, with data checksum: %.3f ms\n",
+           1E-6 * (t1 - t0), 1E-6 * (t2 - t1));
+
+    if (keys != NULL) {
+        n = read_keys(&pk, keys);
+        miss = 0;
+        t0 = bench_ns();
+        for (i = 0; i < n; i++) {
+            if (racc_kstore_find(&ks, pk + i * CRYPTO_PUBLICKEYBYTES) == NULL)
+                miss++;
+        }
+        t1 = bench_ns();
+        for (i = 0; i < n; i++) {
+            racc_decode_pk(&r_pk, pk + i * CRYPTO_PUBLICKEYBYTES);
+            if (ks.a_off != 0)
+                racc_expand_a(a, r_pk.a_seed);
+        }
+        t2 = bench_ns();
+        if (n > 0) {
+            printf("%zu keys, %zu not found\n", n, miss);
+            printf("lookup: %10.3f us/key\n", 1E-3 * (t1 - t0) / n);
+            printf("decode%s: %10.3f us/key\n",
+                   ks.a_off != 0 ? " + ExpandA" : "", 1E-3 * (t2 - t1) / n);
+        }
+        free(pk);
+        if (miss > 0) {
+            racc_kstore_close(&ks);
+            return 1;
+        }
+    }
+    racc_kstore_close(&ks);
+
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s -g count keys.bin     generate public keys\n"
+           "       %s [-A] -w store keys.bin  build a store\n"
+           "       %s -c store [keys.bin]     check a store (and lookups)\n"
+           "  keys.bin holds concatenated %d-byte %s public keys.\n"
+           "  -A  also store ExpandA(seed) (NTT domain) of each key\n",
+           prog, prog, prog, CRYPTO_PUBLICKEYBYTES, CRYPTO_ALGNAME);
+}
+
+int main(int argc, char **argv)
+{
+    int c, ret;
+    bool expand;
+    size_t n;
+    uint8_t *pk;
+    const char *out, *chk;
+    long gen;
+
+    expand = false;
+    out = NULL;
+    chk = NULL;
+    gen = -1;
+
+    while ((c = getopt(argc, argv, "g:w:c:Ah")) != -1) {
+        switch (c) {
+            case 'g':
+                gen = atol(optarg);
+                break;
+            case 'w':
+                out = optarg;
+                break;
+            case 'c':
+                chk = optarg;
+                break;
+            case 'A':
+                expand = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (gen >= 0 && optind + 1 == argc)
+        return gen_keys(argv[optind], (size_t) gen);
+
+    if (chk != NULL && optind + 1 >= argc)
+        return check_store(chk, optind < argc ? argv[optind] : NULL);
+
+    if (out != NULL && optind + 1 == argc) {
+        n = read_keys(&pk, argv[optind]);
+        if (n == 0)
+            return 1;
+        errno = 0;
+        ret = racc_kstore_write(out, pk, n, expand);
+        free(pk);
+        if (ret != 0) {
+            fprintf(stderr, "%s: %s\n", out,
+                    errno != 0 ? strerror(errno) : "invalid public key");
+            return 1;
+        }
+        printf("%s: %zu keys%s\n", out, n, expand ? " (with A)" : "");
+        return 0;
+    }
+
+    usage(argv[0]);
+
+    return 1;
+}
+
+// NIST_KAT
+#endif
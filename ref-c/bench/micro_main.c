@@ -0,0 +1,325 @@
+//  micro_main.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Per-kernel microbenchmark (xmicro).
+
+#ifndef NIST_KAT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "plat_local.h"
+#include "nist_random.h"
+#include "bench_util.h"
+#include "racc_core.h"
+#include "racc_serial.h"
+#include "polyr.h"
+#include "keccakf1600.h"
+#include "xof_sample.h"
+#include "mask_random.h"
+#include "aes_ni.h"
+#include "racc_vcache.h"
+#include "racc_kreg.h"
+#include "api.h"
+
+//  kernel inputs and outputs (set up by micro_init)
+
+static int64_t p_a[RACC_N], p_b[RACC_N], p_c[RACC_N], p_r[RACC_N];
+static int64_t p_w[RACC_K][RACC_N];
+static int64_t p_t[RACC_N], p_c1[RACC_N], p_cp[RACC_N];
+static int64_t p_z[RACC_D][RACC_N];
+static int64_t p_ar[RACC_ELL][RACC_N], p_mw[RACC_D][RACC_N];
+static uint64_t k_st[25];
+static uint8_t x_seed[RACC_AS_SZ + 8];
+static uint8_t x_mu[RACC_MU_SZ];
+static uint8_t x_ch[RACC_CH_SZ];
+static mask_random_t m_mrg;
+static racc_pk_t r_pk;
+static racc_sk_t r_sk;
+static racc_sig_t r_sig;
+static uint8_t b_sk[CRYPTO_SECRETKEYBYTES];
+static uint8_t b_sig[CRYPTO_BYTES];
+static uint8_t b_pk[CRYPTO_PUBLICKEYBYTES];
+static uint8_t b_sm[CRYPTO_BYTES + 3], b_m2[CRYPTO_BYTES + 3];
+static racc_vcache_t v_vc;
+static racc_kreg_t g_kr, g_kra;
+static aes256_ctr_drbg_t a_drbg, r_drbg, b_drbg;
+static uint8_t a_buf[4096];
+
+//  kernels
+
+static void k_fntt()        { polyr_fntt(p_a); }
+static void k_intt()        { polyr_intt(p_a); }
+static void k_fntt_d()      { int j; for (j = 0; j < RACC_D; j++)
+                                  polyr_fntt(p_z[j]); }
+static void k_fntt_n()      { polyr_fntt_n(p_z[0], RACC_D); }
+static void k_intt_d()      { int j; for (j = 0; j < RACC_D; j++)
+                                  polyr_intt(p_z[j]); }
+static void k_intt_n()      { polyr_intt_n(p_z[0], RACC_D); }
+static void k_ntt_mula()    { polyr_ntt_mula(p_r, p_a, p_b, p_c); }
+static void k_matvec()      { polyr_ntt_matvec(p_mw[0], p_ar[0], r_sk.s[0][0],
+                                               RACC_D); }
+static void k_ct_ntt()      { polyr_shlm(p_r, p_t, RACC_NUT, RACC_Q);
+                              polyr_fntt(p_r);
+                              polyr_ntt_cmul(p_r, p_r, p_cp); }
+static void k_ct_sparse()   { polyr_sparse_mul(p_r, p_c1, p_t);
+                              polyr_shlmod(p_r, p_r, RACC_NUT, RACC_Q); }
+static void k_keccak()      { keccak_f1600(k_st); }
+static void k_sample_q()    { xof_sample_q(p_r, x_seed, sizeof(x_seed)); }
+static void k_sample_u()    { xof_sample_u(p_r, RACC_UW, x_seed,
+                                           RACC_SEC + 8); }
+static void k_sample_ut()   { xof_sample_u(p_r, RACC_UT, x_seed,
+                                           RACC_SEC + 8); }
+static void k_chal_hash()   { xof_chal_hash(x_ch, x_mu, p_w); }
+static void k_chal_poly()   { xof_chal_poly(p_r, x_ch); }
+static void k_mask_poly()   { mask_random_poly(&m_mrg, p_r, 0); }
+static void k_zero_enc()    { racc_zero_encoding(p_z, &m_mrg); }
+static void k_encode_sig()  { racc_encode_sig(b_sig, CRYPTO_BYTES, &r_sig); }
+static void k_decode_sig()  { racc_decode_sig(&r_sig, b_sig); }
+static void k_decode_sk()   { racc_decode_sk(&r_sk, b_sk); }
+static void k_vcache_hit()  { unsigned long long l;
+                              racc_vcache_open(&v_vc, b_m2, &l, b_sm,
+                                               sizeof(b_sm), b_pk); }
+static void k_sign_open()   { unsigned long long l;
+                              crypto_sign_open(b_m2, &l, b_sm,
+                                               sizeof(b_sm), b_pk); }
+static void k_ctr_lvl(int lvl)
+{
+    int max = aesni_level();
+
+    aesni_select(lvl);
+    aes256ctr_xof(&a_drbg, a_buf, sizeof(a_buf));
+    aesni_select(max);
+}
+static void k_ctr_t()       { k_ctr_lvl(AESNI_NONE); }
+static void k_ctr_ni()      { k_ctr_lvl(AESNI_AES); }
+static void k_ctr_vaes()    { k_ctr_lvl(AESNI_VAES); }
+static void k_rand(aes256_ctr_drbg_t *ctx)
+{
+    int i;
+
+    nist_randombytes_ctx(ctx);
+    for (i = 0; i < 64; i++) {
+        randombytes(a_buf + 16 * i, 16);
+    }
+    nist_randombytes_ctx(NULL);
+}
+static void k_rand_nist()   { k_rand(&r_drbg); }
+static void k_rand_res()    { k_rand(&b_drbg); }
+static void k_kreg_open()   { unsigned long long l;
+                              racc_kreg_open(&g_kr, b_m2, &l, b_sm,
+                                             sizeof(b_sm), b_pk); }
+static void k_kreg_open_a() { unsigned long long l;
+                              racc_kreg_open(&g_kra, b_m2, &l, b_sm,
+                                             sizeof(b_sm), b_pk); }
+
+typedef struct {
+    const char *name;
+    void (*fn)();
+} micro_t;
+
+static const micro_t micro_list[] = {
+    { "polyr_fntt",         k_fntt          },
+    { "polyr_intt",         k_intt          },
+    { "fntt x d (loop)",    k_fntt_d        },
+    { "polyr_fntt_n (d)",   k_fntt_n        },
+    { "intt x d (loop)",    k_intt_d        },
+    { "polyr_intt_n (d)",   k_intt_n        },
+    { "polyr_ntt_mula",     k_ntt_mula      },
+    { "ntt_matvec (d)",     k_matvec        },
+    { "c*t (ntt)",          k_ct_ntt        },
+    { "c*t (sparse)",       k_ct_sparse     },
+    { "keccak_f1600",       k_keccak        },
+    { "xof_sample_q",       k_sample_q      },
+    { "xof_sample_u",       k_sample_u      },
+    { "xof_sample_u (ut)",  k_sample_ut     },
+    { "xof_chal_hash",      k_chal_hash     },
+    { "xof_chal_poly",      k_chal_poly     },
+    { "mask_random_poly",   k_mask_poly     },
+    { "zero_encoding",      k_zero_enc      },
+    { "racc_encode_sig",    k_encode_sig    },
+    { "racc_decode_sig",    k_decode_sig    },
+    { "racc_decode_sk",     k_decode_sk     },
+    { "vcache_open (hit)",  k_vcache_hit    },
+    { "aes_ctr 4k (ttab)",  k_ctr_t         },
+    { "aes_ctr 4k (ni)",    k_ctr_ni        },
+    { "aes_ctr 4k (vaes)",  k_ctr_vaes      },
+    { "rand 64x16 (nist)",  k_rand_nist     },
+    { "rand 64x16 (buf)",   k_rand_res      },
+    { "crypto_sign_open",   k_sign_open     },
+    { "kreg_open (pk)",     k_kreg_open     },
+    { "kreg_open (pk+A)",   k_kreg_open_a   },
+    { NULL,                 NULL            }
+};
+
+//  deterministic inputs; a real key and signature for the serializers
+
+static void micro_init()
+{
+    int i, j;
+    uint8_t seed[48];
+    unsigned long long smlen;
+
+    for (i = 0; i < 48; i++) {
+        seed[i] = i;
+    }
+    nist_randombytes_init(seed, NULL, 256);
+
+    xof_sample_q(p_a, seed, 16);
+    xof_sample_q(p_b, seed, 17);
+    xof_sample_q(p_c, seed, 18);
+    for (i = 0; i < RACC_ELL; i++) {
+        xof_sample_q(p_ar[i], seed, 32 + i);
+    }
+    for (i = 0; i < RACC_K; i++) {
+        xof_sample_q(p_w[i], seed, 20 + i);
+        for (j = 0; j < RACC_N; j++) {
+            p_w[i][j] %= RACC_QW;
+        }
+    }
+    memset(k_st, 0, sizeof(k_st));
+    randombytes(x_seed, sizeof(x_seed));
+    randombytes(x_mu, sizeof(x_mu));
+    mask_random_init(&m_mrg);
+    aes256ctr_xof_init(&a_drbg, seed);
+    aes256ctr_xof_init(&r_drbg, seed);
+    aes256ctr_xof_init(&b_drbg, seed);
+    aes256ctr_buffer(&b_drbg, true);
+
+    racc_core_keygen(&r_pk, &r_sk);
+    racc_core_sign(&r_sig, x_mu, &r_sk);
+    memcpy(x_ch, r_sig.ch, RACC_CH_SZ);
+    polyr_copy(p_t, r_pk.t[0]);
+    xof_chal_poly(p_c1, x_ch);
+    polyr_copy(p_cp, p_c1);
+    polyr_fntt(p_cp);
+    racc_encode_sk(b_sk, &r_sk);
+    racc_encode_sig(b_sig, CRYPTO_BYTES, &r_sig);
+
+    crypto_sign_keypair(b_pk, b_sk);
+    crypto_sign(b_sm, &smlen, (const uint8_t *) "abc", 3, b_sk);
+    if (racc_vcache_init(&v_vc, 1024, RACC_VC_CLOCK) != 0 ||
+        racc_vcache_open(&v_vc, b_m2, &smlen, b_sm, sizeof(b_sm), b_pk) != 0)
+        printf("micro_init: racc_vcache_open() failed\n");
+    if (racc_kreg_init(&g_kr, 64, false) != 0 ||
+        racc_kreg_init(&g_kra, 64, true) != 0)
+        printf("micro_init: racc_kreg_init() failed\n");
+}
+
+//  time one kernel: "warm" untimed calls, then "n" timed calls
+
+static void micro_run(const micro_t *m, size_t warm, size_t n, uint64_t *v)
+{
+    size_t i;
+    uint64_t t;
+    bench_stat_t st;
+
+    for (i = 0; i < warm; i++) {
+        m->fn();
+    }
+    for (i = 0; i < n; i++) {
+        t = plat_get_cycle();
+        m->fn();
+        v[i] = plat_get_cycle() - t;
+    }
+
+    bench_stat(&st, v, n);
+    printf("%s\t%-18s min=%10.0f  med=%10.0f  avg=%12.1f  cyc\n",
+           CRYPTO_ALGNAME, m->name, st.min, st.p50, st.avg);
+}
+
+static void usage(const char *prog)
+{
+    const micro_t *m;
+
+    printf("Usage: %s [-n samples] [-w warmup] [-c cpu] [kernel ..]\n"
+           "  -n  timed calls per kernel (default: 1000)\n"
+           "  -w  untimed warmup calls per kernel (default: 100)\n"
+           "  -c  pin to this processor (default: 0; -1: no pinning)\n"
+           "Kernels:", prog);
+    for (m = micro_list; m->name != NULL; m++) {
+        printf(" %s", m->name);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int c, i, cpu;
+    size_t n, warm;
+    uint64_t *v;
+    const micro_t *m;
+
+    n = 1000;
+    warm = 100;
+    cpu = 0;
+
+    while ((c = getopt(argc, argv, "n:w:c:h")) != -1) {
+        switch (c) {
+            case 'n':
+                n = (size_t) atol(optarg);
+                break;
+            case 'w':
+                warm = (size_t) atol(optarg);
+                break;
+            case 'c':
+                cpu = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (n < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    //  check kernel names
+    for (i = optind; i < argc; i++) {
+        for (m = micro_list; m->name != NULL; m++) {
+            if (strcmp(argv[i], m->name) == 0)
+                break;
+        }
+        if (m->name == NULL) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (cpu >= 0 && bench_pin_cpu(cpu) != 0) {
+        printf("%s: could not pin to processor %d.\n", argv[0], cpu);
+    }
+
+    v = calloc(n, sizeof(uint64_t));
+    if (v == NULL) {
+        perror("calloc()");
+        return 1;
+    }
+
+    micro_init();
+
+    printf("=== xmicro %s (n=%zu, warmup=%zu, cpu=%d) ===\n",
+           CRYPTO_ALGNAME, n, warm, cpu);
+
+    for (m = micro_list; m->name != NULL; m++) {
+        if (optind < argc) {
+            for (i = optind; i < argc; i++) {
+                if (strcmp(argv[i], m->name) == 0)
+                    break;
+            }
+            if (i == argc)
+                continue;
+        }
+        micro_run(m, warm, n, v);
+    }
+
+    free(v);
+
+    return 0;
+}
+
+// NIST_KAT
+#endif
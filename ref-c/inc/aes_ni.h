@@ -0,0 +1,50 @@
+//  aes_ni.h
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === AES-256 with x86-64 AES-NI / VAES instructions (runtime selected).
+
+#ifndef _AES_NI_H_
+#define _AES_NI_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "plat_local.h"
+#include "test_aes1kt.h"
+
+//  backends in order of preference
+#define AESNI_NONE  0           //  portable T-table code (test_aes1kt.c)
+#define AESNI_AES   1           //  AES-NI, 8 blocks in parallel
+#define AESNI_VAES  2           //  AVX-512 VAES, 16 blocks in parallel
+
+#if defined(PLAT_ARCH_X64) && defined(__GNUC__) && !defined(NO_AESNI)
+#define AESNI_X64
+#endif
+
+//  Backend used by the DRBG: the best one that the processor supports,
+//  limited to "max" (e.g. AESNI_NONE to force the portable code) once
+//  aesni_select() has been called. Returns the backend.
+
+int aesni_level();
+int aesni_select(int max);
+
+#ifdef AESNI_X64
+
+//  Same round key layout as aes256_enc_key() (bytes in memory order).
+
+void aesni256_enc_key(uint32_t rk[AES256_RK_WORDS], const uint8_t key[32]);
+
+//  CTR mode: for each of "n" blocks, increment the 128-bit big-endian
+//  counter "ctr" and write its encryption to "out" (as in the NIST DRBG).
+
+void aesni256_ctr(  uint8_t *out, size_t n, uint8_t ctr[16],
+                    const uint32_t rk[AES256_RK_WORDS], int lvl);
+
+//  AESNI_X64
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  _AES_NI_H_
@@ -26,6 +26,14 @@ void keccak_extract(uint64_t* state, uint8_t* data, size_t rate);
 //  absorb "rate" bytes via xor into the state
 void keccak_xorbytes(uint64_t* state, const uint8_t* data, size_t rate);
 
+//  RACC_PROFILE: permutations run by the calling thread
+#ifdef RACC_PROFILE
+extern PLAT_TLS uint64_t keccak_count;
+#define KECCAK_COUNT() { keccak_count++; }
+#else
+#define KECCAK_COUNT()
+#endif
+
 #ifdef __cplusplus
 }
 #endif
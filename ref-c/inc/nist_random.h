@@ -17,12 +17,21 @@ extern "C" {
 
 #else
 //  use the built-in version
+#include <stdbool.h>
 #include "test_aes1kt.h"
 
+//  reservoir of a buffered DRBG
+#ifndef AESDRBG_RES_SZ
+#define AESDRBG_RES_SZ 4096
+#endif
+
 typedef struct {
     uint8_t key[32];
     uint8_t ctr[16];
     uint32_t rk[AES256_RK_WORDS];
+    bool res_on;                    //  buffered (aes256ctr_buffer)
+    size_t res_i;                   //  first unused byte of res
+    uint8_t res[AESDRBG_RES_SZ];    //  reservoir; used bytes are zeroed
 } aes256_ctr_drbg_t;
 
 extern aes256_ctr_drbg_t aesdrbg_global_ctx;
@@ -35,10 +44,28 @@ void nist_randombytes_init(const uint8_t entropy_input[48],
 
 int nist_randombytes(uint8_t *x, size_t xlen);
 
+//  use DRBG "ctx" for randombytes() in the calling thread (NULL: global)
+
+void nist_randombytes_ctx(aes256_ctr_drbg_t *ctx);
+
+//  DRBG set for the calling thread by nist_randombytes_ctx() (NULL: global)
+
+aes256_ctr_drbg_t *nist_randombytes_get_ctx();
+
 //  seed expander
 
 void aes256ctr_xof_init(aes256_ctr_drbg_t *ctx, const uint8_t *input48);
 
+int aes256ctr_xof(void *ctx, void *buf, size_t len);
+
+//  Buffered mode (off after aes256ctr_xof_init): randombytes() requests
+//  are served from a reservoir filled AESDRBG_RES_SZ bytes at a time, with
+//  one DRBG update per refill instead of one per request. Faster, but the
+//  output stream differs from the NIST DRBG, so not for test vectors.
+//  Switching it off wipes the reservoir.
+
+void aes256ctr_buffer(aes256_ctr_drbg_t *ctx, bool on);
+
 #define randombytes(v, len) nist_randombytes(v, len)
 
 //  NIST_KAT
@@ -98,6 +98,16 @@ extern "C" {
 #define XPROOFS
 #endif  //  __CPROVER__
 
+//  thread-local storage class
+
+#ifndef PLAT_TLS
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define PLAT_TLS _Thread_local
+#else
+#define PLAT_TLS __thread
+#endif
+#endif
+
 //  get cycle counts
 
 static inline uint64_t plat_get_cycle()
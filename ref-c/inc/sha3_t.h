@@ -25,8 +25,10 @@ extern "C" {
 
 //  === Incremental interface for FIPS 202 functions ===
 
+//  Input is xored directly into the state "s" and output is read from it;
+//  "i" is the byte position within the rate "r".
+
 typedef struct {
-    uint8_t b[200];
     uint64_t s[25];
     size_t r, i;
 } sha3_t;
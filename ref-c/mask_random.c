@@ -8,6 +8,7 @@
 #include "mask_random.h"
 #include "plat_local.h"
 #include "racc_param.h"
+#include "racc_prof.h"
 
 #if RACC_D > 1
 #ifdef MASK_RANDOM_ASCON
@@ -138,6 +139,8 @@ void mask_random_poly(mask_random_t *mrg, int64_t *r, size_t ri)
     int64_t z;
     uint64_t s[5];
 
+    RACC_PROF_COUNT(mask);
+
     //  local copy of state allows some additional optimizations
     memcpy(s, mrg->s[ri], sizeof(s));
 
@@ -233,6 +236,8 @@ void mask_random_poly(mask_random_t *mrg, int64_t *r, size_t ri)
     int64_t z;
     uint64_t s[2];
 
+    RACC_PROF_COUNT(mask);
+
     //  local state allows some additional optimizations
     memcpy(s, mrg->s[ri], sizeof(s));
     for (i = 0; i < RACC_N; i++) {
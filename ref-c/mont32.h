@@ -64,6 +64,15 @@
 #define MONT_C4Q1 1048477
 #define MONT_C4Q2 15632846
 
+/*
+    (c2q1, c2q2) accounts for FFT^-1 (n) and 2 REDC's (2^-32).
+    c2q1 = lift(Mod(q2*n,q1)^-1 * (2^32)^2)
+    c2q2 = lift(Mod(q1*n,q2)^-1 * (2^32)^2)
+*/
+
+#define MONT_C2Q1 524158
+#define MONT_C2Q2 16515137
+
 /*
     (d2q1, d2q2) accounts for 2 REDC's (2^-32) -- no FFT^-1
     d2q1 = lift(Mod(q2,q1)^-1 * (2^32)^2)
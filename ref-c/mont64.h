@@ -21,6 +21,7 @@
     r   = 2^64 % q
     rr  = r^2 % q
     ni  = lift(rr * Mod(n,q)^-1)
+    nr  = lift(r * Mod(n,q)^-1)
     qi  = lift(Mod(-q,2^64)^-1)
 */
 
@@ -28,6 +29,7 @@
 #define MONT_R 129308285697266L
 #define MONT_RR 506614974174448L
 #define MONT_NI 293083792181611L
+#define MONT_NR 290199112777663L
 #define MONT_QI 2231854466648768511L
 
 //  Addition and subtraction
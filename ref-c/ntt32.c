@@ -426,12 +426,11 @@ void polyr_fntt(int64_t *v)
     }
 }
 
-//  2x32 CRT: Inverse NTT (x^n+1).
+//  2x32 CRT: Inverse NTT butterflies (x^n+1), not normalized.
 
-void polyr_intt(int64_t *v)
+static void intt_bfly(int64_t *v)
 {
     size_t i, j, k;
-    int64_t x;
     int32_t x1, x2, y1, y2, z1, z2;
     int32_t *p0, *p1, *p2;
 
@@ -465,25 +464,91 @@ void polyr_intt(int64_t *v)
             p0 = p2;
         }
     }
+}
+
+//  2x32 CRT: Inverse NTT (x^n+1).
+
+void polyr_intt(int64_t *v)
+{
+    intt_bfly(v);
 
     //  join & normalize
-    p0 = (int32_t *)v;
-    p1 = (int32_t *)(v + RACC_N);
+    polyr2_join(v, MONT_C4Q1, MONT_C4Q2);
+}
 
-    while (p0 < p1) {
+//  2x32 CRT: Inverse NTT, exact inverse of polyr_fntt() (2 REDC's less).
+
+void polyr_intt_plain(int64_t *v)
+{
+    intt_bfly(v);
+    polyr2_join(v, MONT_C2Q1, MONT_C2Q2);
+}
+
+//  2x32 CRT: Inverse NTT, subtract and round (one pass after the
+//  butterflies): v = ( (intt(v) - u) mod q + 2^(sh-1) ) >> sh, 0 <= v < m.
+
+void polyr_intt_round(int64_t *v, const int64_t *u, size_t sh, int64_t m)
+{
+    size_t i;
+    int64_t x, h;
+    int32_t x1, x2;
+    int32_t *p0;
+
+    intt_bfly(v);
+
+    h = 1ll << (sh - 1);
+    p0 = (int32_t *)v;
+    for (i = 0; i < RACC_N; i++) {
         x1 = mont32_cadd(mont32_mulq1(p0[0], MONT_C4Q1), RACC_Q1);
         x2 = mont32_cadd(mont32_mulq2(p0[1], MONT_C4Q2), RACC_Q2);
 
         x = (((int64_t)RACC_Q2) * ((int64_t)x1)) +
             (((int64_t)RACC_Q1) * ((int64_t)x2));
-
-        //  we have [0,~2q], put to [0,q-1]
         x = mont64_csub(x, RACC_Q);
 
-        *((int64_t *)p0) = x;
+        x = mont64_cadd(x - u[i], RACC_Q);
+        v[i] = mont64_csub((x + h) >> sh, m);
         p0 += 2;
     }
 }
 
+//  2x32 CRT: Forward and inverse NTT of "n" consecutive polynomials.
+
+void polyr_fntt_n(int64_t *v, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        polyr_fntt(v + i * RACC_N);
+    }
+}
+
+void polyr_intt_n(int64_t *v, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        polyr_intt(v + i * RACC_N);
+    }
+}
+
+//  2x32 CRT: Matrix row times "d" vectors:  r[k] = sum_j a[j] * v[j][k].
+//  The 32-bit products do not leave room to accumulate several of them,
+//  so each one is reduced as in polyr_ntt_mula().
+
+void polyr_ntt_matvec(  int64_t *r, const int64_t *a, const int64_t *v,
+                        size_t d)
+{
+    size_t j, k;
+
+    for (k = 0; k < d; k++) {
+        polyr_ntt_cmul(r + k * RACC_N, a, v + k * RACC_N);
+        for (j = 1; j < RACC_ELL; j++) {
+            polyr_ntt_mula(r + k * RACC_N, a + j * RACC_N,
+                           v + (j * d + k) * RACC_N, r + k * RACC_N);
+        }
+    }
+}
+
 //  POLYR_Q32
 #endif
@@ -170,68 +170,167 @@ static const int64_t racc_w_64[511] = {
     161675321641364, 491504876037951, 413884745894778, 323627212742799,
     118642261844448, 403988630153751, 470675365723139};
 
-//  Forward NTT (negacyclic -- evaluate polynomial at factors of x^n+1).
+//  polynomials transformed together by polyr_fntt_n() / polyr_intt_n()
+#define NTT_GROUP 4
 
-void polyr_fntt(int64_t *v)
+//  Forward NTT butterflies on "m" consecutive polynomials; each twiddle
+//  factor is applied to all of them before moving to the next one.
+
+static inline __attribute__((always_inline))
+void fntt_grp(int64_t *v, size_t m)
 {
-    size_t i, j, k;
+    size_t i, j, k, l, p;
     int64_t x, y, z;
-    int64_t *p0, *p1, *p2;
+    int64_t *p0, *p1;
 
     const int64_t *w = racc_w_64;
 
     for (k = 1, j = RACC_N >> 1; j > 0; k <<= 1, j >>= 1) {
 
-        p0 = v;
         for (i = 0; i < k; i++) {
             z = *w++;
-            p1 = p0 + j;
-            p2 = p1 + j;
-
-            while (p1 < p2) {
-                x = *p0;
-                y = *p1;
-                y = mont64_mulq(y, z);
-                *p0++ = mont64_add(x, y);
-                *p1++ = mont64_sub(x, y);
+
+            for (p = 0; p < m; p++) {
+                p0 = v + p * RACC_N + 2 * i * j;
+                p1 = p0 + j;
+
+                for (l = 0; l < j; l++) {
+                    x = p0[l];
+                    y = mont64_mulq(p1[l], z);
+                    p0[l] = mont64_add(x, y);
+                    p1[l] = mont64_sub(x, y);
+                }
             }
-            p0 = p2;
         }
     }
 }
 
-//  Reverse NTT (negacyclic -- x^n+1), normalize by 1/(n*r).
+//  Reverse NTT butterflies on "m" consecutive polynomials. If "c" is not
+//  zero, the last level also multiplies by "c" (Montgomery) and reduces
+//  to [0, q), saving a separate normalization pass; otherwise the output
+//  is not normalized.
 
-void polyr_intt(int64_t *v)
+static inline __attribute__((always_inline))
+void intt_grp(int64_t *v, size_t m, int64_t c)
 {
-    size_t i, j, k;
+    size_t i, j, k, l, p;
     int64_t x, y, z;
-    int64_t *p0, *p1, *p2;
+    int64_t *p0, *p1;
 
     const int64_t *w = &racc_w_64[RACC_N - 2];
 
-    for (j = 1, k = RACC_N >> 1; k > 0; j <<= 1, k >>= 1) {
-
-        p0 = v;
+    for (j = 1, k = RACC_N >> 1; k > (c != 0 ? 1 : 0); j <<= 1, k >>= 1) {
 
         for (i = 0; i < k; i++) {
             z = *w--;
-            p1 = p0 + j;
-            p2 = p1 + j;
-
-            while (p1 < p2) {
-                x = *p0;
-                y = *p1;
-                *p0++ = mont64_add(x, y);
-                y = mont64_sub(y, x);
-                *p1++ = mont64_mulq(y, z);
+
+            for (p = 0; p < m; p++) {
+                p0 = v + p * RACC_N + 2 * i * j;
+                p1 = p0 + j;
+
+                for (l = 0; l < j; l++) {
+                    x = p0[l];
+                    y = p1[l];
+                    p0[l] = mont64_add(x, y);
+                    y = mont64_sub(y, x);
+                    p1[l] = mont64_mulq(y, z);
+                }
             }
-            p0 = p2;
         }
     }
 
-    //  normalization
-    polyr_ntt_smul(v, v, MONT_NI);
+    if (c == 0)
+        return;
+
+    //  last level (j = n/2) with the scaling by c
+    z = mont64_cadd(mont64_mulq(*w, c), RACC_Q);
+    for (p = 0; p < m; p++) {
+        p0 = v + p * RACC_N;
+        p1 = p0 + j;
+
+        for (l = 0; l < j; l++) {
+            x = p0[l];
+            y = p1[l];
+            p0[l] = mont64_cadd(mont64_mulq(mont64_add(x, y), c), RACC_Q);
+            y = mont64_sub(y, x);
+            p1[l] = mont64_cadd(mont64_mulq(y, z), RACC_Q);
+        }
+    }
+}
+
+//  Forward NTT (negacyclic -- evaluate polynomial at factors of x^n+1).
+
+void polyr_fntt(int64_t *v)
+{
+    fntt_grp(v, 1);
+}
+
+//  Forward NTT of "n" consecutive polynomials.
+
+void polyr_fntt_n(int64_t *v, size_t n)
+{
+    while (n >= NTT_GROUP) {
+        fntt_grp(v, NTT_GROUP);
+        v += NTT_GROUP * RACC_N;
+        n -= NTT_GROUP;
+    }
+    if (n > 0) {
+        fntt_grp(v, n);
+    }
+}
+
+//  Reverse NTT butterflies (negacyclic -- x^n+1), not normalized.
+
+static void intt_bfly(int64_t *v)
+{
+    intt_grp(v, 1, 0);
+}
+
+//  Reverse NTT (negacyclic -- x^n+1), normalize by 1/(n*r).
+
+void polyr_intt(int64_t *v)
+{
+    intt_grp(v, 1, MONT_NI);
+}
+
+//  Reverse NTT of "n" consecutive polynomials, normalize by 1/(n*r).
+
+void polyr_intt_n(int64_t *v, size_t n)
+{
+    size_t m;
+
+    while (n > 0) {
+        m = n < NTT_GROUP ? n : NTT_GROUP;
+        intt_grp(v, m, MONT_NI);
+        v += m * RACC_N;
+        n -= m;
+    }
+}
+
+//  Reverse NTT, normalize by 1/n: the exact inverse of polyr_fntt(), for
+//  inputs that are not the result of a Montgomery product.
+
+void polyr_intt_plain(int64_t *v)
+{
+    intt_grp(v, 1, MONT_NR);
+}
+
+//  Reverse NTT, subtract and round (one pass after the butterflies):
+//  v = ( (intt(v) - u) mod q + 2^(sh-1) ) >> sh,  0 <= v < m.
+
+void polyr_intt_round(int64_t *v, const int64_t *u, size_t sh, int64_t m)
+{
+    size_t i;
+    int64_t x, h;
+
+    intt_bfly(v);
+
+    h = 1ll << (sh - 1);
+    for (i = 0; i < RACC_N; i++) {
+        x = mont64_cadd(mont64_mulq(v[i], MONT_NI), RACC_Q);
+        x = mont64_cadd(x - u[i], RACC_Q);
+        v[i] = mont64_csub((x + h) >> sh, m);
+    }
 }
 
 //  Scalar multiplication, Montgomery reduction.
@@ -269,5 +368,33 @@ void polyr_ntt_mula(int64_t *r, const int64_t *a, const int64_t *b,
     }
 }
 
+//  coefficients per tile: a tile of all RACC_ELL polynomials of "a" stays
+//  in L1 while it is used for every vector
+#define MATVEC_TILE 64
+
+//  Matrix row times "d" vectors:  r[k] = sum_j a[j] * v[j][k], Montgomery
+//  reduction. The products are accumulated in 128 bits and reduced once:
+//  RACC_ELL * |a * v| < 2^111 as required by mont64_redc().
+
+void polyr_ntt_matvec(  int64_t *r, const int64_t *a, const int64_t *v,
+                        size_t d)
+{
+    size_t i, j, k, t;
+    __int128 x;
+
+    for (t = 0; t < RACC_N; t += MATVEC_TILE) {
+        for (k = 0; k < d; k++) {
+            for (i = t; i < t + MATVEC_TILE; i++) {
+                x = 0;
+                for (j = 0; j < RACC_ELL; j++) {
+                    x += ((__int128) a[j * RACC_N + i]) *
+                         ((__int128) v[(j * d + k) * RACC_N + i]);
+                }
+                r[k * RACC_N + i] = mont64_cadd(mont64_redc(x), RACC_Q);
+            }
+        }
+    }
+}
+
 //  POLYR_Q32
 #endif
@@ -134,6 +134,26 @@ void polyr_shlm(int64_t *r, const int64_t *a, size_t sh, int64_t m)
     }
 }
 
+//  Left shift with full reduction:  r = a * 2^sh  (mod m),  0 <= r < m.
+//  Inputs may be negative; |a * 2^sh| must be less than 2^63.
+
+void polyr_shlmod(int64_t *r, const int64_t *a, size_t sh, int64_t m)
+{
+    size_t i;
+    int64_t x, h;
+    double mi;
+
+    //  quotient estimate in floating point is off by at most one
+    mi = 1.0 / ((double) m);
+    for (i = 0; i < RACC_N; i++) {
+        x = a[i] * (1ll << sh);
+        h = (int64_t) (((double) x) * mi);
+        x -= h * m;
+        x = mont64_cadd(x, m);
+        r[i] = mont64_csub(x, m);
+    }
+}
+
 //  Right shift:  r = a >> sh, conditionally subtract m on overflow.
 
 void polyr_shrm(int64_t *r, const int64_t *a, size_t sh, int64_t m)
@@ -181,3 +201,41 @@ void polyr_nonneg(int64_t *r, const int64_t *a, int64_t m)
         r[i] = mont64_cadd(a[i], m);
     }
 }
+
+//  Sparse multiply:  r = c * a  in Z[x]/(x^n+1), "c" has coefficients in
+//  {-1, 0, 1}. No reduction; for small "a": accumulates in 32 bits, so
+//  (weight of c) * max |a[i]| must be less than 2^31.
+
+void polyr_sparse_mul(int64_t *r, const int64_t *c, const int64_t *a)
+{
+    size_t i, j;
+    int32_t x[RACC_N], y[RACC_N];
+
+    for (i = 0; i < RACC_N; i++) {
+        x[i] = (int32_t) a[i];
+        y[i] = 0;
+    }
+
+    //  signed rotation of "a" by each nonzero position of "c"
+    for (i = 0; i < RACC_N; i++) {
+        if (c[i] > 0) {
+            for (j = 0; j < RACC_N - i; j++) {
+                y[i + j] += x[j];
+            }
+            for (j = RACC_N - i; j < RACC_N; j++) {
+                y[i + j - RACC_N] -= x[j];
+            }
+        } else if (c[i] < 0) {
+            for (j = 0; j < RACC_N - i; j++) {
+                y[i + j] -= x[j];
+            }
+            for (j = RACC_N - i; j < RACC_N; j++) {
+                y[i + j - RACC_N] += x[j];
+            }
+        }
+    }
+
+    for (i = 0; i < RACC_N; i++) {
+        r[i] = y[i];
+    }
+}
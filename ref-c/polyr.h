@@ -45,6 +45,10 @@ void polyr_negm(int64_t *r, int64_t *a, int64_t m);
 //  Left shift:  r = a << sh, conditionally subtract m on overflow.
 void polyr_shlm(int64_t *r, const int64_t *a, size_t sh, int64_t m);
 
+//  Left shift with full reduction:  r = a * 2^sh  (mod m),  0 <= r < m.
+//  Inputs may be negative; |a * 2^sh| must be less than 2^63.
+void polyr_shlmod(int64_t *r, const int64_t *a, size_t sh, int64_t m);
+
 //  Right shift:  r = a >> sh, conditionally subtract m on overflow.
 void polyr_shrm(int64_t *r, const int64_t *a, size_t sh, int64_t m);
 
@@ -71,12 +75,36 @@ void polyr_ntt_cmul(int64_t *r, const int64_t *a, const int64_t *b);
 void polyr_ntt_mula(int64_t *r, const int64_t *a, const int64_t *b,
                     const int64_t *c);
 
+//  Matrix row times "d" vectors:  r[k] = sum_j a[j] * v[j][k], Montgomery
+//  reduction (the same as polyr_ntt_cmul() and RACC_ELL-1 polyr_ntt_mula()).
+//  "a" is RACC_ELL polynomials, "v" is [RACC_ELL][d] and "r" [d] of them.
+void polyr_ntt_matvec(  int64_t *r, const int64_t *a, const int64_t *v,
+                        size_t d);
+
+//  Sparse multiply:  r = c * a  in Z[x]/(x^n+1), "c" has coefficients in
+//  {-1, 0, 1}. No reduction; (weight of c) * max |a[i]| must be < 2^31.
+void polyr_sparse_mul(int64_t *r, const int64_t *c, const int64_t *a);
+
 //  Forward NTT (negacyclic -- evaluate polynomial at factors of x^n+1).
 void polyr_fntt(int64_t *v);
 
 //  Reverse NTT (negacyclic -- x^n+1), normalize by 1/(n*r).
 void polyr_intt(int64_t *v);
 
+//  Forward and reverse NTT of "n" consecutive polynomials "v" (such as the
+//  shares of a masked polynomial), several at a time.
+void polyr_fntt_n(int64_t *v, size_t n);
+void polyr_intt_n(int64_t *v, size_t n);
+
+//  Reverse NTT, normalize by 1/n: the exact inverse of polyr_fntt(), for
+//  inputs that are not the result of a Montgomery product.
+void polyr_intt_plain(int64_t *v);
+
+//  Reverse NTT, subtract and round (one pass after the butterflies):
+//  v = ( (intt(v) - u) mod q + 2^(sh-1) ) >> sh,  0 <= v < m.
+//  "u" must be in 0 <= u < q; intt() is polyr_intt().
+void polyr_intt_round(int64_t *v, const int64_t *u, size_t sh, int64_t m);
+
 #ifdef POLYR_Q32
 //  2x32 CRT: Split into two-prime representation (in-place).
 void polyr2_split(int64_t *v);
@@ -3,12 +3,32 @@
 
 //  === Raccoon signature scheme -- NIST KAT Generator API.
 
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "api.h"
 #include "racc_core.h"
 #include "racc_serial.h"
 #include "xof_sample.h"
+#include "nist_random.h"
+#include "mask_random.h"
+#include "plat_local.h"
+
+//  signature attempt statistics of this thread
+
+static PLAT_TLS racc_sign_stat_t racc_stat;
+
+//  Copy the signing statistics of the calling thread to "st" (if not NULL)
+//  and reset them if "clear" is set.
+
+void racc_sign_stat(racc_sign_stat_t *st, bool clear)
+{
+    if (st != NULL)
+        memcpy(st, &racc_stat, sizeof(racc_sign_stat_t));
+    if (clear)
+        memset(&racc_stat, 0, sizeof(racc_sign_stat_t));
+}
 
 //  Generates a keypair - pk is the public key and sk is the secret key.
 
@@ -28,6 +48,41 @@ crypto_sign_keypair(  unsigned char *pk, unsigned char *sk)
     return  0;
 }
 
+//  Sign digest "mu" with "r_sk" (and "a" = ExpandA, or NULL) into "sig"
+//  (CRYPTO_BYTES, zero padded), retrying on encoding overflow; updates the
+//  statistics of the calling thread.
+
+static void sign_mu(uint8_t *sig, const uint8_t mu[RACC_MU_SZ],
+                    racc_sk_t *r_sk, const int64_t (*a)[RACC_ELL][RACC_N])
+{
+    racc_sig_t  r_sig;          //  internal-format signature
+    size_t  sig_sz;
+    int     att, enc;
+
+    //  several trials may be needed in case of signature size overflow
+    att = 0;
+    enc = 0;
+    do {
+        if (a != NULL)                                  //  create signature
+            att += racc_core_sign_a(&r_sig, mu, r_sk, a);
+        else
+            att += racc_core_sign(&r_sig, mu, r_sk);
+        sig_sz = racc_encode_sig(sig, CRYPTO_BYTES, &r_sig);
+        if (sig_sz == 0)
+            enc++;
+    } while (sig_sz == 0);
+
+    //  statistics
+    racc_stat.sig++;
+    racc_stat.bound_fail += att - enc - 1;
+    racc_stat.enc_fail += enc;
+    racc_stat.hist[att <= RACC_STAT_HIST ? att - 1 : RACC_STAT_HIST - 1]++;
+    racc_stat.last_bound = att - enc - 1;
+    racc_stat.last_enc = enc;
+
+    memset(sig + sig_sz, 0, CRYPTO_BYTES - sig_sz);  //   zero padding
+}
+
 //  Sign a message: sm is the signed message, m is the original message,
 //  and sk is the secret key.
 
@@ -37,25 +92,17 @@ crypto_sign(unsigned char *sm, unsigned long long *smlen,
             const unsigned char *sk)
 {
     racc_sk_t   r_sk;           //  internal-format secret key
-    racc_sig_t  r_sig;          //  internal-format signature
     uint8_t mu[RACC_MU_SZ];
-    size_t  sig_sz;
+
     //  deserialize secret key
     if (CRYPTO_SECRETKEYBYTES != racc_decode_sk(&r_sk, sk))
         return -1;
 
     xof_chal_mu(mu, r_sk.pk.tr, m, mlen);           //  compute mu
 
-    //  several trials may be needed in case of signature size overflow
-    do {
-        racc_core_sign(&r_sig, mu, &r_sk);          //  create signature
-
-        //  The NIST API expects an "envelope" consisting of the message
-        //  together with signature. we put the signature first.
-        sig_sz = racc_encode_sig(sm, CRYPTO_BYTES, &r_sig);
-    } while (sig_sz == 0);
-
-    memset(sm + sig_sz, 0, CRYPTO_BYTES - sig_sz);  //  zero padding
+    //  The NIST API expects an "envelope" consisting of the message
+    //  together with signature. we put the signature first.
+    sign_mu(sm, mu, &r_sk, NULL);
     memcpy(sm + CRYPTO_BYTES, m, mlen);             //  add the message
 
     *smlen = mlen + CRYPTO_BYTES;
@@ -97,3 +144,287 @@ crypto_sign_open(unsigned char *m, unsigned long long *mlen,
     return  0;
 }
 
+//  lattice part of racc_verify_pipe()
+
+typedef struct {
+    const uint8_t *sig;             //  encoded signature
+    const racc_pk_t *pk;            //  decoded public key
+    racc_sig_t r_sig;               //  decoded signature
+    int64_t vw[RACC_K][RACC_N];     //  w'
+    bool ok;                        //  decoded and within bounds
+} verify_pipe_t;
+
+static void *verify_pipe_w(void *arg)
+{
+    verify_pipe_t *vp = (verify_pipe_t *) arg;
+
+    vp->ok = CRYPTO_BYTES == racc_decode_sig(&vp->r_sig, vp->sig) &&
+             racc_core_verify_w(vp->vw, &vp->r_sig, vp->pk, NULL);
+
+    return NULL;
+}
+
+//  Verify a detached signature "sig" (CRYPTO_BYTES) on message "m" of
+//  "mlen" bytes under public key "pk". For long messages the lattice part
+//  runs on a second thread while the message is hashed.
+
+int racc_verify_pipe(   const uint8_t *sig, const uint8_t *m, size_t mlen,
+                        const uint8_t *pk)
+{
+    racc_pk_t   r_pk;           //  internal-format public key
+    uint8_t     mu[RACC_MU_SZ];
+    verify_pipe_t vp;
+    pthread_t   th;
+    bool        thr;
+
+    //  the public key hash tr is needed for mu
+    if (CRYPTO_PUBLICKEYBYTES != racc_decode_pk(&r_pk, pk))
+        return -1;
+
+    vp.sig = sig;
+    vp.pk = &r_pk;
+
+    //  start decoding the signature and computing w'
+    thr = mlen >= RACC_PIPE_MIN &&
+          pthread_create(&th, NULL, verify_pipe_w, &vp) == 0;
+    if (!thr)
+        verify_pipe_w(&vp);
+
+    //  meanwhile, compute mu
+    xof_chal_mu(mu, r_pk.tr, m, mlen);
+
+    if (thr)
+        pthread_join(th, NULL);
+
+    if (!vp.ok || !racc_core_verify_mu(vp.vw, &vp.r_sig, mu))
+        return -1;
+
+    return  0;
+}
+
+
+//  === Batch key generation and signing ===
+
+//  a contiguous part [i0, i0 + n) of a batch, run by one thread
+
+typedef struct batch_part_s {
+    void (*fn)(struct batch_part_s *);  //  processes the part
+    const void *arg;                //  arguments of the batch
+    size_t i0, n;                   //  first item, number of items
+    int ret;                        //  0 or -1
+#ifndef NIST_KAT
+    pthread_t th;                   //  worker thread
+    bool run;                       //  thread was started
+    aes256_ctr_drbg_t drbg;         //  private randombytes()
+#endif
+} batch_part_t;
+
+#ifndef NIST_KAT
+
+//  run a part with its own DRBG; also called inline if a thread could not
+//  be created, so the DRBG of the calling thread is restored afterwards
+
+static void *batch_part_w(void *arg)
+{
+    batch_part_t *bp = (batch_part_t *) arg;
+    aes256_ctr_drbg_t *prev;
+
+    prev = nist_randombytes_get_ctx();
+    nist_randombytes_ctx(&bp->drbg);
+    bp->fn(bp);
+    nist_randombytes_ctx(prev);
+
+    return NULL;
+}
+
+//  NIST_KAT
+#endif
+
+//  Run "fn" over items 0 .. n - 1, split over the caller and nthr - 1
+//  workers, each with a buffered randombytes() DRBG seeded from the
+//  caller's. Serial (in the calling thread) if nthr <= 1 or NIST_KAT.
+//  Returns 0, or -1 if any part failed.
+
+static int batch_run(   void (*fn)(batch_part_t *), const void *arg,
+                        size_t n, int nthr)
+{
+    batch_part_t bp0;
+#ifndef NIST_KAT
+    int i, ret;
+    size_t m;
+    uint8_t seed[48];
+    batch_part_t *bp;
+    pthread_attr_t attr;
+
+    if (nthr > 1 && (size_t) nthr > n)
+        nthr = (int) n;
+    bp = nthr > 1 ? calloc(nthr - 1, sizeof(batch_part_t)) : NULL;
+#else
+    (void) nthr;
+#endif
+
+    bp0.fn = fn;
+    bp0.arg = arg;
+    bp0.i0 = 0;
+    bp0.n = n;
+
+#ifndef NIST_KAT
+    if (bp != NULL) {
+
+        //  the caller takes the first part, workers the rest
+        m = n / nthr;
+        bp0.n = n - m * (nthr - 1);
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, RACC_BATCH_STACK);
+        for (i = 0; i < nthr - 1; i++) {
+            bp[i].fn = fn;
+            bp[i].arg = arg;
+            bp[i].i0 = bp0.n + i * m;
+            bp[i].n = m;
+            randombytes(seed, sizeof(seed));
+            aes256ctr_xof_init(&bp[i].drbg, seed);
+            aes256ctr_buffer(&bp[i].drbg, true);
+            bp[i].run = pthread_create(&bp[i].th, &attr,
+                                       batch_part_w, &bp[i]) == 0;
+            if (!bp[i].run)
+                batch_part_w(&bp[i]);
+        }
+        pthread_attr_destroy(&attr);
+        memset(seed, 0, sizeof(seed));
+    }
+#endif
+
+    fn(&bp0);
+
+#ifndef NIST_KAT
+    ret = bp0.ret;
+    if (bp != NULL) {
+        for (i = 0; i < nthr - 1; i++) {
+            if (bp[i].run)
+                pthread_join(bp[i].th, NULL);
+            if (bp[i].ret != 0)
+                ret = -1;
+            memset(&bp[i].drbg, 0, sizeof(bp[i].drbg));
+        }
+        free(bp);
+    }
+    return ret;
+#else
+    return bp0.ret;
+#endif
+}
+
+//  arguments of racc_keygen_batch()
+
+typedef struct {
+    uint8_t *pk, *sk;
+} keygen_batch_t;
+
+static void keygen_batch_part(batch_part_t *bp)
+{
+    size_t i;
+    const keygen_batch_t *kb = (const keygen_batch_t *) bp->arg;
+    racc_pk_t   r_pk;           //  internal-format public key
+    racc_sk_t   r_sk;           //  internal-format secret key
+    mask_random_t mrg;
+
+    mask_random_init(&mrg);
+
+    bp->ret = 0;
+    for (i = bp->i0; i < bp->i0 + bp->n; i++) {
+        racc_core_keygen_m(&r_pk, &r_sk, &mrg);
+        if (CRYPTO_PUBLICKEYBYTES !=
+                racc_encode_pk(kb->pk + i * CRYPTO_PUBLICKEYBYTES, &r_pk) ||
+            CRYPTO_SECRETKEYBYTES !=
+                racc_encode_sk(kb->sk + i * CRYPTO_SECRETKEYBYTES, &r_sk))
+            bp->ret = -1;
+    }
+    memset(&r_sk, 0, sizeof(r_sk));
+    memset(&mrg, 0, sizeof(mrg));
+}
+
+//  Generate "n" keypairs into "pk" (n * CRYPTO_PUBLICKEYBYTES) and "sk"
+//  (n * CRYPTO_SECRETKEYBYTES), encoded as by crypto_sign_keypair(). The
+//  batch is split over "nthr" threads (the caller and nthr - 1 workers),
+//  each with its own mask random generator and a randombytes() DRBG
+//  seeded from the caller's; nthr <= 1 runs in the calling thread, with
+//  the same output as "n" calls to crypto_sign_keypair(). Returns 0, or
+//  -1 if a key could not be encoded.
+
+int racc_keygen_batch(uint8_t *pk, uint8_t *sk, size_t n, int nthr)
+{
+    keygen_batch_t kb;
+
+    kb.pk = pk;
+    kb.sk = sk;
+
+    return batch_run(keygen_batch_part, &kb, n, nthr);
+}
+
+//  arguments of racc_sign_batch()
+
+typedef struct {
+    uint8_t *sig;
+    const uint8_t *const *m;
+    const size_t *mlen;
+    const uint8_t *const *sk;
+} sign_batch_t;
+
+static void sign_batch_part(batch_part_t *bp)
+{
+    size_t i;
+    const sign_batch_t *sb = (const sign_batch_t *) bp->arg;
+    const uint8_t *key;
+    uint8_t *sig;
+    uint8_t mu[RACC_MU_SZ];
+    racc_sk_t   r_sk;           //  internal-format secret key
+    int64_t a[RACC_K][RACC_ELL][RACC_N];
+
+    bp->ret = 0;
+    key = NULL;
+    for (i = bp->i0; i < bp->i0 + bp->n; i++) {
+        sig = sb->sig + i * CRYPTO_BYTES;
+
+        //  decode the key and expand A when the key changes; only the
+        //  pointer is compared, as comparing key bytes would leak timing
+        if (sb->sk[i] != key) {
+            key = sb->sk[i];
+            if (CRYPTO_SECRETKEYBYTES != racc_decode_sk(&r_sk, key)) {
+                memset(sig, 0, CRYPTO_BYTES);
+                bp->ret = -1;
+                key = NULL;
+                continue;
+            }
+            racc_expand_a(a, r_sk.pk.a_seed);
+        }
+
+        xof_chal_mu(mu, r_sk.pk.tr, sb->m[i], sb->mlen[i]);
+        sign_mu(sig, mu, &r_sk, (const int64_t (*)[RACC_ELL][RACC_N]) a);
+    }
+    memset(&r_sk, 0, sizeof(r_sk));
+    memset(a, 0, sizeof(a));
+}
+
+//  Create detached signatures "sig" (n * CRYPTO_BYTES, zero padded as in
+//  crypto_sign) of messages "m[i]" of "mlen[i]" bytes under encoded secret
+//  keys "sk[i]". Consecutive items with the same key pointer share its
+//  decoding and ExpandA. The batch is split over "nthr" threads as in
+//  racc_keygen_batch(). Each part keeps a decoded key and its matrix A
+//  (RACC_K * RACC_ELL * RACC_N * 8 bytes, up to 252 kB) on the stack of
+//  its thread, in addition to the signing frames; workers get
+//  RACC_BATCH_STACK, and the calling thread needs as much. Returns 0, or
+//  -1 if a key could not be decoded (its signatures are zeroed).
+
+int racc_sign_batch(uint8_t *sig, const uint8_t *const m[],
+                    const size_t mlen[], const uint8_t *const sk[],
+                    size_t n, int nthr)
+{
+    sign_batch_t sb;
+
+    sb.sig = sig;
+    sb.m = m;
+    sb.mlen = mlen;
+    sb.sk = sk;
+
+    return batch_run(sign_batch_part, &sb, n, nthr);
+}
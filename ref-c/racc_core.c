@@ -3,6 +3,9 @@
 
 //  === Raccoon signature scheme -- core scheme.
 
+#ifdef RACC_SIGN_SPEC
+#define _GNU_SOURCE
+#endif
 #include <string.h>
 
 #include "plat_local.h"
@@ -14,6 +17,26 @@
 #include "xof_sample.h"
 #include "nist_random.h"
 #include "mask_random.h"
+#include "racc_prof.h"
+
+#if defined(RACC_SIGN_REJECT) && defined(NIST_KAT)
+#error "RACC_SIGN_REJECT changes the signatures."
+#endif
+
+#ifdef RACC_SIGN_SPEC
+#ifdef NIST_KAT
+#error "RACC_SIGN_SPEC changes the order of randombytes() calls."
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+typedef atomic_bool sign_stop_t;
+#define SIGN_STOPPED(stop) ((stop) != NULL && atomic_load(stop))
+#else
+typedef bool sign_stop_t;
+#define SIGN_STOPPED(stop) ((void) (stop), false)
+#endif
 
 //  ExpandA(): Use domain separated XOF to create matrix elements
 
@@ -36,6 +59,20 @@ static void expand_aij( int64_t aij[RACC_N], int i_k, int i_ell,
     polyr_fntt(aij);
 }
 
+//  ExpandA() of the full matrix, for verifiers that keep it with the key
+
+void racc_expand_a( int64_t a[RACC_K][RACC_ELL][RACC_N],
+                    const uint8_t seed[RACC_AS_SZ])
+{
+    int i, j;
+
+    for (i = 0; i < RACC_K; i++) {
+        for (j = 0; j < RACC_ELL; j++) {
+            expand_aij(a[i][j], i, j, seed);
+        }
+    }
+}
+
 //  Decode(): Collapse shares
 
 static void racc_decode(int64_t r[RACC_N], const int64_t m[RACC_D][RACC_N])
@@ -71,7 +108,7 @@ static void racc_ntt_decode(int64_t r[RACC_N], const int64_t m[RACC_D][RACC_N])
 //  ZeroEncoding(d) -> [[z]]d
 //  in-place version
 
-static void zero_encoding(int64_t z[RACC_D][RACC_N], mask_random_t *mrg)
+void racc_zero_encoding(int64_t z[RACC_D][RACC_N], mask_random_t *mrg)
 {
 #if RACC_D == 1
     (void) mrg;
@@ -113,7 +150,7 @@ static void racc_refresh(int64_t x[RACC_D][RACC_N], mask_random_t *mrg)
     int64_t z[RACC_D][RACC_N];
 
     //  --- 1.  [[z]] <- ZeroEncoding(d)
-    zero_encoding(z, mrg);
+    racc_zero_encoding(z, mrg);
 
     //  --- 2.  return [[x]]' := [[x]] + [[z]]
     for (i = 0; i < RACC_D; i++) {
@@ -134,7 +171,7 @@ static void racc_ntt_refresh(int64_t x[RACC_D][RACC_N], mask_random_t *mrg)
     int64_t z[RACC_D][RACC_N];
 
     //  --- 1.  [[z]] <- ZeroEncoding(d)
-    zero_encoding(z, mrg);
+    racc_zero_encoding(z, mrg);
 
     //  --- 2.  return [[x]]' := [[x]] + [[z]]
     for (i = 0; i < RACC_D; i++) {
@@ -198,6 +235,32 @@ static inline void round_shift_r(int64_t *r, int64_t q, int s)
     }
 }
 
+//  hint h := w - y (mod q_w), centered; 0 <= w, y < q_w
+
+static inline void hint_sub(int64_t *h, const int64_t *w, const int64_t *y)
+{
+    int i;
+    int64_t x, c;
+
+    c = RACC_QW >> 1;
+    for (i = 0; i < RACC_N; i++) {
+        x = mont64_cadd(w[i] - y[i], RACC_QW);
+        x = mont64_csub(x + c, RACC_QW);
+        h[i] = x - c;
+    }
+}
+
+//  w' := y + h (mod q_w); 0 <= y < q_w, h is centered
+
+static inline void hint_add(int64_t *w, const int64_t *y, const int64_t *h)
+{
+    int i;
+
+    for (i = 0; i < RACC_N; i++) {
+        w[i] = mont64_csub(y[i] + mont64_cadd(h[i], RACC_QW), RACC_QW);
+    }
+}
+
 //  CheckBounds(sig) -> {OK or FAIL}
 
 static bool racc_check_bounds(  const int64_t h[RACC_K][RACC_N],
@@ -264,28 +327,40 @@ static bool racc_check_bounds(  const int64_t h[RACC_K][RACC_N],
 
 void racc_core_keygen(racc_pk_t *pk, racc_sk_t *sk)
 {
-    int i, j, k;
-    int64_t ai[RACC_ELL][RACC_N];
-    int64_t mt[RACC_D][RACC_N];
     mask_random_t mrg;
 
     //  intialize the mask random generator
     mask_random_init(&mrg);
 
+    racc_core_keygen_m(pk, sk, &mrg);
+}
+
+//  Key generation with the caller's mask random generator "mrg", which can
+//  be initialized once for a batch of keys.
+
+void racc_core_keygen_m(racc_pk_t *pk, racc_sk_t *sk, mask_random_t *mrg)
+{
+    int i, j;
+    int64_t ai[RACC_ELL][RACC_N];
+    int64_t mt[RACC_D][RACC_N];
+
+    RACC_PROF_BEGIN();
+
     //  --- 1.  seed <- {0,1}^kappa
     randombytes(pk->a_seed, RACC_AS_SZ);
 
     for (i = 0; i < RACC_ELL; i++) {
 
         //  --- 3.  [[s]] <- ell * ZeroEncoding(d)
-        zero_encoding(sk->s[i], &mrg);
+        racc_zero_encoding(sk->s[i], mrg);
+        RACC_PROF_LAP(RACC_PROF_KG_ZENC);
 
         //  --- 4.  [[s]] <- AddRepNoise([[s]], ut, rep)
-        add_rep_noise(sk->s[i], i, RACC_UT, &mrg);
+        add_rep_noise(sk->s[i], i, RACC_UT, mrg);
+        RACC_PROF_LAP(RACC_PROF_KG_NOISE);
 
-        for (j = 0; j < RACC_D; j++) {
-            polyr_fntt(sk->s[i][j]);
-        }
+        polyr_fntt_n(sk->s[i][0], RACC_D);
+        RACC_PROF_LAP(RACC_PROF_KG_NTT);
     }
 
     for (i = 0; i < RACC_K; i++) {
@@ -294,103 +369,375 @@ void racc_core_keygen(racc_pk_t *pk, racc_sk_t *sk)
         for (j = 0; j < RACC_ELL; j++) {
             expand_aij(ai[j], i, j, pk->a_seed);
         }
+        RACC_PROF_LAP(RACC_PROF_KG_EXPA);
 
         //  --- 5.  [[t]] := A * [[s]]
-        for (j = 0; j < RACC_D; j++) {
-            polyr_ntt_cmul(mt[j], sk->s[0][j], ai[0]);
-            for (k = 1; k < RACC_ELL; k++) {
-                polyr_ntt_mula(mt[j], sk->s[k][j], ai[k], mt[j]);
-            }
-            polyr_intt(mt[j]);
-        }
+        polyr_ntt_matvec(mt[0], ai[0], sk->s[0][0], RACC_D);
+        RACC_PROF_LAP(RACC_PROF_KG_MMUL);
+        polyr_intt_n(mt[0], RACC_D);
+        RACC_PROF_LAP(RACC_PROF_KG_NTT);
 
         //  --- 6.  [[t]] <- AddRepNoise([[t]], ut, rep)
-        add_rep_noise( mt, i, RACC_UT, &mrg);
+        add_rep_noise( mt, i, RACC_UT, mrg);
+        RACC_PROF_LAP(RACC_PROF_KG_NOISE);
 
         //  --- 7.  t := Decode([[t]])
         racc_decode(pk->t[i], mt);
 
         //  --- 8.  t := round( t_m )_q->q_t
         round_shift_r(pk->t[i], RACC_QT, RACC_NUT);
+        RACC_PROF_LAP(RACC_PROF_KG_ROUND);
     }
 
     //  --- 9.  return ( (vk := seed, t), sk:= (vk, [[s]]) )
     memcpy(&sk->pk, pk, sizeof(racc_pk_t));
+
+    RACC_PROF_END(RACC_PROF_KG_ALL);
 }
 
-//  === racc_core_sign ===
-//  Create a detached signature "sig" for digest "mu" using secret key "sk".
+//  Commitment: steps 4-9 of Sign; depends on A but not on the message.
+//  If "stop" is set (by another thread) the computation is abandoned and
+//  false is returned.
 
-void racc_core_sign(racc_sig_t *sig, const uint8_t mu[RACC_MU_SZ],
-                    racc_sk_t *sk)
+//  only the signing thread (stop == NULL) is profiled; a speculative
+//  worker has no RACC_PROF_BEGIN() of its own
+#ifdef RACC_PROFILE
+#define COMMIT_LAP(ph) { if (stop == NULL) RACC_PROF_LAP(ph); }
+#else
+#define COMMIT_LAP(ph)
+#endif
+
+static bool racc_commit( int64_t mr[RACC_ELL][RACC_D][RACC_N],
+                         int64_t vw[RACC_K][RACC_N],
+                         const int64_t ma[RACC_K][RACC_ELL][RACC_N],
+                         mask_random_t *mrg, const sign_stop_t *stop)
 {
-    int i, j, k;
-    int64_t ma[RACC_K][RACC_ELL][RACC_N];
-    int64_t mr[RACC_ELL][RACC_D][RACC_N];
+    int i;
     int64_t mw[RACC_D][RACC_N];
-    int64_t vw[RACC_K][RACC_N];
-    int64_t y[RACC_N];
-    int64_t vz[RACC_ELL][RACC_N];
-    int64_t u[RACC_N], c_poly[RACC_N];
-    bool rsp = false;
-    mask_random_t mrg;
 
-    //  intialize the mask random generator
-    mask_random_init(&mrg);
+    for (i = 0; i < RACC_ELL; i++) {
 
-    //  --- 1.  (vk, [[s]]) := [[sk]], (seed, t) := vk      [ caller ]
-    //  --- 2.  mu := H( H(vk) || msg )                     [ caller ]
+        if (SIGN_STOPPED(stop))
+            return false;
+
+        //  --- 4.  [[r]] <- ZeroEncoding()
+        racc_zero_encoding(mr[i], mrg);
+        COMMIT_LAP(RACC_PROF_SG_ZENC);
+
+        //  --- 5.  [[r]] <- AddRepNoise([[r]], uw, rep)
+        add_rep_noise(mr[i], i, RACC_UW, mrg);
+        COMMIT_LAP(RACC_PROF_SG_NOISE);
+
+        //  (Convert to NTT domain)
+        polyr_fntt_n(mr[i][0], RACC_D);
+        COMMIT_LAP(RACC_PROF_SG_NTT);
+    }
 
-    //  --- 3.  A := ExpandA(seed)
     for (i = 0; i < RACC_K; i++) {
-        for (j = 0; j < RACC_ELL; j++) {
-            expand_aij(ma[i][j], i, j, sk->pk.a_seed);
-        }
+
+        if (SIGN_STOPPED(stop))
+            return false;
+
+        //  --- 6.  [[w]] := A * [[r]]
+        polyr_ntt_matvec(mw[0], ma[i][0], mr[0][0], RACC_D);
+        COMMIT_LAP(RACC_PROF_SG_MMUL);
+        polyr_intt_n(mw[0], RACC_D);
+        COMMIT_LAP(RACC_PROF_SG_NTT);
+
+        //  --- 7.  [[w]] <- AddRepNoise([[w]], uw, rep)
+        add_rep_noise(mw, i, RACC_UW, mrg);
+        COMMIT_LAP(RACC_PROF_SG_NOISE);
+
+        //  --- 8.  w := Decode([[w]])
+        racc_decode(vw[i], mw);
+
+        //  --- 9.  w := round( w )_q->q_w
+        round_shift_r(vw[i], RACC_QW, RACC_NUW);
+        COMMIT_LAP(RACC_PROF_SG_ROUND);
     }
 
-    do {
+    return true;
+}
 
-        for (i = 0; i < RACC_ELL; i++) {
+#ifdef RACC_SIGN_SPEC
+
+//  Speculative commitment: each signing thread has a worker thread that
+//  computes the commitment of the next attempt into its own buffers while
+//  the current attempt computes its response. After a CheckBounds
+//  rejection the next attempt starts from the spare commitment and only
+//  computes its response; on success the spare is abandoned, and wiped by
+//  whichever thread sees it last. The worker is created at the first
+//  signature of a thread and kept until that thread exits. It has its own
+//  randombytes() DRBG (seeded once from the caller's) and mask RNG, is not
+//  profiled, and runs at idle priority where available, so that a spare
+//  that is not needed does not slow the signing thread down. The signing
+//  thread never waits for an abandoned spare: while one is still being
+//  stopped, an attempt runs without speculation.
+
+//  worker stack: the refresh / noise frames grow with d
+#define SIGN_SPEC_STACK (4 << 20)
+
+typedef struct {
+    pthread_t th;                               //  worker thread
+    pthread_mutex_t mtx;                        //  guards busy, done, quit
+    pthread_cond_t cv;                          //  state changed
+    bool busy;                                  //  computing a commitment
+    bool done;                                  //  commitment is complete
+    bool quit;                                  //  worker should exit
+    sign_stop_t stop;                           //  abandon request
+    aes256_ctr_drbg_t drbg;                     //  private randombytes()
+    const int64_t (*ma)[RACC_ELL][RACC_N];      //  matrix A
+    int64_t mr[RACC_ELL][RACC_D][RACC_N];       //  spare [[r]]
+    int64_t vw[RACC_K][RACC_N];                 //  spare w
+} sign_spec_t;
+
+//  the worker of each signing thread
+static pthread_key_t sign_spec_key;
+static pthread_once_t sign_spec_once = PTHREAD_ONCE_INIT;
+static bool sign_spec_key_ok = false;
+
+static void *sign_spec_main(void *arg)
+{
+    sign_spec_t *sp = (sign_spec_t *) arg;
+    mask_random_t mrg;
+    bool done;
+#ifdef SCHED_IDLE
+    struct sched_param prm;
+
+    memset(&prm, 0, sizeof(prm));
+    (void) pthread_setschedparam(pthread_self(), SCHED_IDLE, &prm);
+#endif
 
-            //  --- 4.  [[r]] <- ZeroEncoding()
-            zero_encoding(mr[i], &mrg);
+    nist_randombytes_ctx(&sp->drbg);
 
-            //  --- 5.  [[r]] <- AddRepNoise([[r]], uw, rep)
-            add_rep_noise(mr[i], i, RACC_UW, &mrg);
+    pthread_mutex_lock(&sp->mtx);
+    for (;;) {
+        while (!sp->busy && !sp->quit)
+            pthread_cond_wait(&sp->cv, &sp->mtx);
+        if (sp->quit)
+            break;
+        pthread_mutex_unlock(&sp->mtx);
 
-            //  (Convert to NTT domain)
-            for (j = 0; j < RACC_D; j++) {
-                polyr_fntt(mr[i][j]);
-            }
+        mask_random_init(&mrg);
+        done = racc_commit(sp->mr, sp->vw, sp->ma, &mrg, &sp->stop);
+        memset(&mrg, 0, sizeof(mrg));
+
+        pthread_mutex_lock(&sp->mtx);
+        if (atomic_load(&sp->stop)) {
+            memset(sp->mr, 0, sizeof(sp->mr));
+            done = false;
         }
+        sp->done = done;
+        sp->busy = false;
+        pthread_cond_broadcast(&sp->cv);
+    }
+    pthread_mutex_unlock(&sp->mtx);
+    nist_randombytes_ctx(NULL);
 
-        for (i = 0; i < RACC_K; i++) {
+    return NULL;
+}
 
-            //  --- 6.  [[w]] := A * [[r]]
-            for (j = 0; j < RACC_D; j++) {
-                polyr_ntt_cmul(mw[j], mr[0][j], ma[i][0]);
-                for (k = 1; k < RACC_ELL; k++) {
-                    polyr_ntt_mula(mw[j], mr[k][j], ma[i][k], mw[j]);
-                }
-                polyr_intt(mw[j]);
-            }
+//  stop the worker "arg" and free it (when its signing thread exits)
+
+static void sign_spec_free(void *arg)
+{
+    sign_spec_t *sp = (sign_spec_t *) arg;
+
+    pthread_mutex_lock(&sp->mtx);
+    atomic_store(&sp->stop, true);
+    sp->quit = true;
+    pthread_cond_broadcast(&sp->cv);
+    pthread_mutex_unlock(&sp->mtx);
+    pthread_join(sp->th, NULL);
+
+    pthread_cond_destroy(&sp->cv);
+    pthread_mutex_destroy(&sp->mtx);
+    memset(sp, 0, sizeof(sign_spec_t));
+    free(sp);
+}
+
+//  fork() child: the worker did not survive, and its DRBG state must not
+//  be shared with the parent. the thread creates a new one when it signs;
+//  the old structure is wiped but not freed (this runs right after fork).
+
+static void sign_spec_forked()
+{
+    sign_spec_t *sp;
+
+    sp = (sign_spec_t *) pthread_getspecific(sign_spec_key);
+    if (sp != NULL) {
+        memset(sp, 0, sizeof(sign_spec_t));
+        pthread_setspecific(sign_spec_key, NULL);
+    }
+}
+
+static void sign_spec_init()
+{
+    sign_spec_key_ok = pthread_key_create(&sign_spec_key, sign_spec_free) == 0
+                    && pthread_atfork(NULL, NULL, sign_spec_forked) == 0;
+}
+
+//  the worker of the calling thread, created at first use; NULL if it
+//  cannot be created (signing then runs without speculation)
+
+static sign_spec_t *sign_spec_get()
+{
+    sign_spec_t *sp;
+    uint8_t seed[48];
+    pthread_attr_t attr;
+    bool ok;
+
+    pthread_once(&sign_spec_once, sign_spec_init);
+    if (!sign_spec_key_ok)
+        return NULL;
+
+    sp = (sign_spec_t *) pthread_getspecific(sign_spec_key);
+    if (sp != NULL)
+        return sp;
+
+    sp = (sign_spec_t *) calloc(1, sizeof(sign_spec_t));
+    if (sp == NULL)
+        return NULL;
+
+    randombytes(seed, sizeof(seed));
+    aes256ctr_xof_init(&sp->drbg, seed);
+    aes256ctr_buffer(&sp->drbg, true);
+    memset(seed, 0, sizeof(seed));
+
+    pthread_mutex_init(&sp->mtx, NULL);
+    pthread_cond_init(&sp->cv, NULL);
+    atomic_init(&sp->stop, false);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, SIGN_SPEC_STACK);
+    ok = pthread_create(&sp->th, &attr, sign_spec_main, sp) == 0;
+    pthread_attr_destroy(&attr);
+
+    if (!ok) {
+        pthread_cond_destroy(&sp->cv);
+        pthread_mutex_destroy(&sp->mtx);
+        memset(sp, 0, sizeof(sign_spec_t));
+        free(sp);
+        return NULL;
+    }
+    if (pthread_setspecific(sign_spec_key, sp) != 0) {
+        sign_spec_free(sp);
+        return NULL;
+    }
+
+    return sp;
+}
+
+//  start computing a spare commitment for matrix "ma" in the background.
+//  returns false (and does nothing) while an abandoned one is stopping
+
+static bool sign_spec_start(sign_spec_t *sp,
+                            const int64_t ma[RACC_K][RACC_ELL][RACC_N])
+{
+    bool ok;
+
+    pthread_mutex_lock(&sp->mtx);
+    ok = !sp->busy;
+    if (ok) {
+        sp->ma = ma;
+        sp->done = false;
+        atomic_store(&sp->stop, false);
+        sp->busy = true;
+        pthread_cond_broadcast(&sp->cv);
+    }
+    pthread_mutex_unlock(&sp->mtx);
+
+    return ok;
+}
+
+//  if "keep" is set, wait for the spare commitment and move it to
+//  (mr, vw); returns true iff it was complete. otherwise abandon it
+
+static bool sign_spec_take(sign_spec_t *sp,
+                           int64_t mr[RACC_ELL][RACC_D][RACC_N],
+                           int64_t vw[RACC_K][RACC_N], bool keep)
+{
+    bool done;
+
+    pthread_mutex_lock(&sp->mtx);
+    if (!keep) {
+        atomic_store(&sp->stop, true);
+        if (!sp->busy)
+            memset(sp->mr, 0, sizeof(sp->mr));
+        pthread_mutex_unlock(&sp->mtx);
+        return false;
+    }
+
+    while (sp->busy)
+        pthread_cond_wait(&sp->cv, &sp->mtx);
+    done = sp->done;
+    if (done) {
+        memcpy(mr, sp->mr, sizeof(sp->mr));
+        memcpy(vw, sp->vw, sizeof(sp->vw));
+        memset(sp->mr, 0, sizeof(sp->mr));
+    }
+    pthread_mutex_unlock(&sp->mtx);
 
-            //  --- 7.  [[w]] <- AddRepNoise([[w]], uw, rep)
-            add_rep_noise(mw, i, RACC_UW, &mrg);
+    return done;
+}
 
-            //  --- 8.  w := Decode([[w]])
-            racc_decode(vw[i], mw);
+//  RACC_SIGN_SPEC
+#endif
 
-            //  --- 9.  w := round( w )_q->q_w
-            round_shift_r(vw[i], RACC_QW, RACC_NUW);
+//  Signing steps 4-21 with matrix "ma" = ExpandA(sk->pk.a_seed); the
+//  caller has started the profile and recorded the ExpandA lap.
+
+static int sign_ma( racc_sig_t *sig, const uint8_t mu[RACC_MU_SZ],
+                    racc_sk_t *sk, const int64_t ma[RACC_K][RACC_ELL][RACC_N])
+{
+    int i, j, att = 0;
+    int64_t y[RACC_N];
+    int64_t vz[RACC_ELL][RACC_N];
+    int64_t u[RACC_N], c_poly[RACC_N], c_ntt[RACC_N];
+    bool rsp = false;
+    mask_random_t mrg;
+    int64_t mr[RACC_ELL][RACC_D][RACC_N];
+    int64_t vw[RACC_K][RACC_N];
+#ifdef RACC_SIGN_SPEC
+    bool have = false, run = false;
+    sign_spec_t *spec = sign_spec_get();
+#endif
+
+    //  intialize the mask random generator
+    mask_random_init(&mrg);
+
+    do {
+
+        RACC_PROF_MARK();
+        att++;
+
+        //  --- 4-9. w := round( Decode( A * [[r]] + noise ) )
+#ifdef RACC_SIGN_SPEC
+        if (!have) {
+            racc_commit(mr, vw, ma, &mrg, NULL);
         }
 
+        //  precompute the commitment of the next attempt
+        run = spec != NULL && sign_spec_start(spec, ma);
+#else
+        racc_commit(mr, vw, ma, &mrg, NULL);
+#endif
+
         //  --- 10. c_hash := ChalHash(w, mu)
         xof_chal_hash(sig->ch, mu, vw);
+        RACC_PROF_LAP(RACC_PROF_SG_CHASH);
 
         //  --- 11. c_poly := ChalPoly(c_hash)
         xof_chal_poly(c_poly, sig->ch);
-        polyr_fntt(c_poly);
+        RACC_PROF_LAP(RACC_PROF_SG_CPOLY);
+        polyr_copy(c_ntt, c_poly);
+        polyr_fntt(c_ntt);
+
+#ifndef POLYR_Q32
+        //  pre-scale c by r so that c * s_j + r_j needs no adjustment
+        polyr_ntt_smul(c_ntt, c_ntt, MONT_RR);
+#endif
+        RACC_PROF_LAP(RACC_PROF_SG_NTT);
 
         for (i = 0; i < RACC_ELL; i++) {
 
@@ -399,80 +746,193 @@ void racc_core_sign(racc_sig_t *sig, const uint8_t mu[RACC_MU_SZ],
 
             //  --- 13. [[r]] <- Refresh([[r]])
             racc_ntt_refresh(mr[i], &mrg);
+            RACC_PROF_LAP(RACC_PROF_SG_REFRESH);
 
             //  --- 14. [[z]] := c_poly * [[s]] + [[r]]
             for (j = 0; j < RACC_D; j++) {
-                //  due to 2x Montgomery
-                polyr_ntt_smul(u, mr[i][j],
 #ifdef POLYR_Q32
-                               MONT_RI1, MONT_RI2);
+                //  due to 2x Montgomery (also reduces the fntt output)
+                polyr_ntt_smul(u, mr[i][j], MONT_RI1, MONT_RI2);
+                polyr_ntt_mula(mr[i][j], c_ntt, sk->s[i][j], u);
 #else
-                               1);
+                polyr_ntt_mula(mr[i][j], c_ntt, sk->s[i][j], mr[i][j]);
 #endif
-                polyr_ntt_mula(mr[i][j], c_poly, sk->s[i][j], u);
             }
+            RACC_PROF_LAP(RACC_PROF_SG_RESP);
 
             //  --- 15. [[r]] <- Refresh([[r]])
             racc_ntt_refresh(mr[i], &mrg);
+            RACC_PROF_LAP(RACC_PROF_SG_REFRESH);
 
             //  --- 16. z := Decode([[z]])
+#ifdef POLYR_Q32
             racc_ntt_decode(sig->z[i], mr[i]);
 
             //  Two consecutive multiplications: Montgomery adjustment
-            polyr_ntt_smul(vz[i], sig->z[i],
-#ifdef POLYR_Q32
-                           MONT_RRR1, MONT_RRR2);
-#else
-                           MONT_RR);
-#endif
+            polyr_ntt_smul(vz[i], sig->z[i], MONT_RRR1, MONT_RRR2);
+            RACC_PROF_LAP(RACC_PROF_SG_RESP);
+
             //  Decode for signature
             polyr_intt(sig->z[i]);
+#else
+            //  (the shares are in the domain of polyr_fntt(), as A*z needs)
+            racc_ntt_decode(vz[i], mr[i]);
+            polyr_copy(sig->z[i], vz[i]);
+            RACC_PROF_LAP(RACC_PROF_SG_RESP);
+
+            //  Decode for signature
+            polyr_intt_plain(sig->z[i]);
+#endif
+            RACC_PROF_LAP(RACC_PROF_SG_NTT);
         }
 
         for (i = 0; i < RACC_K; i++) {
 
             //  --- 17. y := A*z - 2^{nu_t} * c_poly * t
-            polyr_ntt_cmul(y, ma[i][0], vz[0]);
-            for (j = 1; j < RACC_ELL; j++) {
-                polyr_ntt_mula(y, ma[i][j], vz[j], y);
-            }
-            polyr_shlm(u, sk->pk.t[i], RACC_NUT, RACC_Q);
+            polyr_ntt_matvec(y, ma[i][0], vz[0], 1);
+            RACC_PROF_LAP(RACC_PROF_SG_MMUL);
+
+            //  c_poly is sparse: c * t by signed rotations
+            polyr_sparse_mul(u, c_poly, sk->pk.t[i]);
+            polyr_shlmod(u, u, RACC_NUT, RACC_Q);
+            RACC_PROF_LAP(RACC_PROF_SG_MMUL);
 
-            polyr_fntt(u);
-            polyr_ntt_cmul(u, u, c_poly);
-            polyr_ntt_subq(y, y, u);
-            polyr_intt(y);
+            //  (y is subtracted and rounded in the INTT's final pass)
+            polyr_intt_round(y, u, RACC_NUW, RACC_QW);
+            RACC_PROF_LAP(RACC_PROF_SG_NTT);
 
             //  --- 18. h := w - round( y )_q->q_w
-            round_shift_r(y, RACC_QW, RACC_NUW);
-            polyr_subm(y, vw[i], y, RACC_QW);
-            polyr_center(sig->h[i], y, RACC_QW);
+            hint_sub(sig->h[i], vw[i], y);
+            RACC_PROF_LAP(RACC_PROF_SG_ROUND);
         }
 
         //  --- 19. sig := (c_hash, h, z)                   [caller]
 
         //  --- 20. if CheckBounds(sig) = FAIL goto Line 4
         rsp = racc_check_bounds(sig->h, sig->z);
+#ifdef RACC_SIGN_REJECT
+        //  benchmarks: time restarts, which are rare with real parameters
+        rsp = rsp && att > RACC_SIGN_REJECT;
+#endif
+        RACC_PROF_LAP(RACC_PROF_SG_BOUNDS);
+
+#ifdef RACC_SIGN_SPEC
+        //  a used [[r]] is never used again; take the spare one
+        memset(mr, 0, sizeof(mr));
+        have = run && sign_spec_take(spec, mr, vw, !rsp);
+#endif
+
+        if (!rsp) {
+            RACC_PROF_SINCE(RACC_PROF_SG_REJECT);
+        }
 
     } while (!rsp);
 
+    RACC_PROF_END(RACC_PROF_SG_ALL);
+
     //  --- 21. return sig                                  [caller]
+    return att;
 }
 
-//  === racc_core_verify ===
-//  Verify that the signature "sig" is valid for digest "mu".
-//  Returns true iff signature is valid, false if not valid.
-bool racc_core_verify(  const racc_sig_t *sig,
-                        const uint8_t mu[RACC_MU_SZ],
-                        const racc_pk_t *pk)
+//  === racc_core_sign_a ===
+//  racc_core_sign() with a precomputed "a" = ExpandA(sk->pk.a_seed) from
+//  racc_expand_a().
+
+int racc_core_sign_a(   racc_sig_t *sig, const uint8_t mu[RACC_MU_SZ],
+                        racc_sk_t *sk, const int64_t (*a)[RACC_ELL][RACC_N])
+{
+    RACC_PROF_BEGIN();
+    RACC_PROF_LAP(RACC_PROF_SG_EXPA);
+
+    return sign_ma(sig, mu, sk, a);
+}
+
+//  === racc_core_sign ===
+//  Create a detached signature "sig" for digest "mu" using secret key "sk".
+
+int racc_core_sign( racc_sig_t *sig, const uint8_t mu[RACC_MU_SZ],
+                    racc_sk_t *sk)
+{
+    int64_t ma[RACC_K][RACC_ELL][RACC_N];
+
+    RACC_PROF_BEGIN();
+
+    //  --- 1.  (vk, [[s]]) := [[sk]], (seed, t) := vk      [ caller ]
+    //  --- 2.  mu := H( H(vk) || msg )                     [ caller ]
+
+    //  --- 3.  A := ExpandA(seed)
+    racc_expand_a(ma, sk->pk.a_seed);
+    RACC_PROF_LAP(RACC_PROF_SG_EXPA);
+
+    return sign_ma(sig, mu, sk, (const int64_t (*)[RACC_ELL][RACC_N]) ma);
+}
+
+//  === racc_core_sk_fork ===
+//  Fork "sk" into "n" copies "out[0..n-1]", each with independently
+//  refreshed shares. The copies hold the same secret and can sign on
+//  separate threads (racc_core_sign() refreshes a key in place).
+
+void racc_core_sk_fork(racc_sk_t *out, const racc_sk_t *sk, size_t n)
+{
+    size_t k;
+    int i;
+    mask_random_t mrg;
+
+    mask_random_init(&mrg);
+
+    for (k = 0; k < n; k++) {
+        memcpy(&out[k], sk, sizeof(racc_sk_t));
+        for (i = 0; i < RACC_ELL; i++) {
+            racc_ntt_refresh(out[k].s[i], &mrg);
+        }
+    }
+    memset(&mrg, 0, sizeof(mrg));
+}
+
+//  === racc_core_sk_check ===
+//  Consistency check: true iff "sk" and "ref" have the same public key and
+//  their shares decode to the same secret. Does not exit early.
+
+bool racc_core_sk_check(const racc_sk_t *sk, const racc_sk_t *ref)
+{
+    int i, j;
+    int64_t x;
+    int64_t u[RACC_N], v[RACC_N];
+
+    x = 0;
+    for (i = 0; i < RACC_ELL; i++) {
+
+        //  u := Decode([[s]]) - Decode([[s']])
+        racc_ntt_decode(u, sk->s[i]);
+        racc_ntt_decode(v, ref->s[i]);
+        polyr_ntt_subq(u, u, v);
+#ifdef POLYR_Q32
+        polyr2_join(u, MONT_D2Q1, MONT_D2Q2);
+#endif
+        for (j = 0; j < RACC_N; j++) {
+            x |= u[j];
+        }
+    }
+
+    return x == 0 && memcmp(&sk->pk, &ref->pk, sizeof(racc_pk_t)) == 0;
+}
+
+//  === racc_core_verify_w ===
+//  Verify, part 1 (steps 2-7): CheckBounds and the message-independent
+//  w' = round( A*z - 2^{nu_t} * c_poly * t )_q->q_w + h.
+//  "a" is ExpandA(seed) from racc_expand_a(), or NULL to expand it here.
+//  Returns false if CheckBounds fails.
+
+bool racc_core_verify_w(int64_t vw[RACC_K][RACC_N],
+                        const racc_sig_t *sig, const racc_pk_t *pk,
+                        const int64_t (*a)[RACC_ELL][RACC_N])
 {
     int i, j;
-    int64_t aij[RACC_N];
+    const int64_t (*pa)[RACC_N];
+    int64_t ai[RACC_ELL][RACC_N];
     int64_t c_poly[RACC_N];
-    int64_t vw[RACC_K][RACC_N];
     int64_t vz[RACC_ELL][RACC_N];
     int64_t t[RACC_N], u[RACC_N];
-    uint8_t c_hchk[RACC_CH_SZ];
 
     //  --- 1.  (c hash, h, z) := sig, (seed, t) := vk      [caller]
 
@@ -480,47 +940,99 @@ bool racc_core_verify(  const racc_sig_t *sig,
     if (!racc_check_bounds(sig->h, sig->z)) {
         return false;
     }
+    RACC_PROF_LAP(RACC_PROF_VF_BOUNDS);
+
     //  --- 3.  mu := H( H(vk) || msg )                     [caller]
 
     //  --- 5.  c_poly := ChalPoly(c_hash)
     xof_chal_poly(c_poly, sig->ch);
-    polyr_fntt(c_poly);
+    RACC_PROF_LAP(RACC_PROF_VF_CPOLY);
 
     for (i = 0; i < RACC_ELL; i++) {
         polyr_copy(vz[i], sig->z[i]);
-        polyr_fntt(vz[i]);
     }
+    polyr_fntt_n(vz[0], RACC_ELL);
+    RACC_PROF_LAP(RACC_PROF_VF_NTT);
 
     for (i = 0; i < RACC_K; i++) {
-        for (j = 0; j < RACC_ELL; j++) {
 
-            //  --- 4.  A := ExpandA(seed)
-            expand_aij(aij, i, j, pk->a_seed);
-
-            //  --- 6.  y = A * z - 2^{nu_t} * c_poly * t
-            if (j == 0) {
-                polyr_ntt_cmul(t, aij, vz[0]);
-            } else {
-                polyr_ntt_mula(t, aij, vz[j], t);
+        //  --- 4.  A := ExpandA(seed)
+        if (a != NULL) {
+            pa = a[i];
+        } else {
+            for (j = 0; j < RACC_ELL; j++) {
+                expand_aij(ai[j], i, j, pk->a_seed);
             }
+            pa = (const int64_t (*)[RACC_N]) ai;
         }
+        RACC_PROF_LAP(RACC_PROF_VF_EXPA);
+
+        //  --- 6.  y = A * z - 2^{nu_t} * c_poly * t
+        polyr_ntt_matvec(t, pa[0], vz[0], 1);
+        RACC_PROF_LAP(RACC_PROF_VF_MMUL);
 
-        polyr_shlm(u, pk->t[i], RACC_NUT, RACC_Q);  //  .. - p_t * t ..
-        polyr_fntt(u);
-        polyr_ntt_cmul(u, u, c_poly);               //  .. Cpoly ..
-        polyr_ntt_subq(vw[i], t, u);
-        polyr_intt(vw[i]);
+        //  c_poly is sparse: c * t by signed rotations
+        polyr_sparse_mul(u, c_poly, pk->t[i]);      //  .. Cpoly * t ..
+        polyr_shlmod(u, u, RACC_NUT, RACC_Q);       //  .. p_t * ..
+        RACC_PROF_LAP(RACC_PROF_VF_MMUL);
+
+        //  (y is subtracted and rounded in the INTT's final pass)
+        polyr_intt_round(t, u, RACC_NUW, RACC_QW);
+        RACC_PROF_LAP(RACC_PROF_VF_NTT);
 
         //  --- 7.  w' = round( y )_q->q_w + h
-        round_shift_r(vw[i], RACC_QW, RACC_NUW);
-        polyr_nonneg(u, sig->h[i], RACC_QW);
-        polyr_addm(vw[i], vw[i], u, RACC_QW);
+        hint_add(vw[i], t, sig->h[i]);
+        RACC_PROF_LAP(RACC_PROF_VF_ROUND);
     }
 
+    return true;
+}
+
+//  === racc_core_verify_mu ===
+//  Verify, part 2 (steps 8-10): check ChalHash(w', mu) against "sig".
+
+bool racc_core_verify_mu(   const int64_t vw[RACC_K][RACC_N],
+                            const racc_sig_t *sig,
+                            const uint8_t mu[RACC_MU_SZ])
+{
+    uint8_t c_hchk[RACC_CH_SZ];
+
     //  --- 8. c_hash' := ChalHash(w', mu)
     xof_chal_hash(c_hchk, mu, vw);
+    RACC_PROF_LAP(RACC_PROF_VF_CHASH);
 
     //  --- 9. if c_hash != c_hash' return FAIL
     //  --- 10. (else) return OK
     return ct_equal(c_hchk, sig->ch, RACC_CH_SZ);
 }
+
+//  === racc_core_verify_a ===
+//  racc_core_verify() with a precomputed "a" = ExpandA(pk->a_seed).
+
+bool racc_core_verify_a(const racc_sig_t *sig,
+                        const uint8_t mu[RACC_MU_SZ],
+                        const racc_pk_t *pk,
+                        const int64_t (*a)[RACC_ELL][RACC_N])
+{
+    int64_t vw[RACC_K][RACC_N];
+    bool ok;
+
+    RACC_PROF_BEGIN();
+
+    ok = racc_core_verify_w(vw, sig, pk, a) &&
+         racc_core_verify_mu(vw, sig, mu);
+
+    RACC_PROF_END(RACC_PROF_VF_ALL);
+
+    return ok;
+}
+
+//  === racc_core_verify ===
+//  Verify that the signature "sig" is valid for digest "mu".
+//  Returns true iff signature is valid, false if not valid.
+bool racc_core_verify(  const racc_sig_t *sig,
+                        const uint8_t mu[RACC_MU_SZ],
+                        const racc_pk_t *pk)
+{
+    return racc_core_verify_a(sig, mu, pk, NULL);
+}
@@ -15,12 +15,26 @@ extern "C" {
 #include <stdbool.h>
 
 #include "racc_param.h"
+#include "mask_random.h"
 
 //  === Global namespace prefix
 #ifdef RACC_
 #define racc_core_keygen RACC_(core_keygen)
+#define racc_core_keygen_m RACC_(core_keygen_m)
 #define racc_core_sign RACC_(core_sign)
+#define racc_core_sign_a RACC_(core_sign_a)
 #define racc_core_verify RACC_(core_verify)
+#define racc_core_verify_w RACC_(core_verify_w)
+#define racc_core_verify_mu RACC_(core_verify_mu)
+#define racc_core_verify_a RACC_(core_verify_a)
+#define racc_expand_a RACC_(expand_a)
+#define racc_verify_pipe RACC_(verify_pipe)
+#define racc_keygen_batch RACC_(keygen_batch)
+#define racc_sign_batch RACC_(sign_batch)
+#define racc_sign_stat RACC_(sign_stat)
+#define racc_zero_encoding RACC_(zero_encoding)
+#define racc_core_sk_fork RACC_(core_sk_fork)
+#define racc_core_sk_check RACC_(core_sk_check)
 #endif
 
 //  === Internal structures ===
@@ -50,16 +64,121 @@ typedef struct {
 //  Generate a public-secret keypair ("pk", "sk").
 void racc_core_keygen(racc_pk_t *pk, racc_sk_t *sk);
 
+//  Key generation with the caller's mask random generator "mrg", which can
+//  be initialized once for a batch of keys.
+void racc_core_keygen_m(racc_pk_t *pk, racc_sk_t *sk, mask_random_t *mrg);
+
 //  Create a detached signature "sig" for digest "mu" using secret key "sk".
-void racc_core_sign(racc_sig_t *sig, const uint8_t mu[RACC_MU_SZ],
+//  Returns the number of attempts made (1 + CheckBounds rejections).
+int racc_core_sign( racc_sig_t *sig, const uint8_t mu[RACC_MU_SZ],
                     racc_sk_t *sk);
 
+//  racc_core_sign() with a precomputed "a" = ExpandA(sk->pk.a_seed) from
+//  racc_expand_a().
+int racc_core_sign_a(   racc_sig_t *sig, const uint8_t mu[RACC_MU_SZ],
+                        racc_sk_t *sk, const int64_t (*a)[RACC_ELL][RACC_N]);
+
 //  Verify that the signature "sig" is valid for digest "mu".
 //  Returns true iff signature is valid, false if not valid.
 bool racc_core_verify(  const racc_sig_t *sig,
                         const uint8_t mu[RACC_MU_SZ],
                         const racc_pk_t *pk);
 
+//  Fork "sk" into "n" copies "out[0..n-1]", each with independently
+//  refreshed shares. The copies hold the same secret and can sign on
+//  separate threads (racc_core_sign() refreshes a key in place).
+void racc_core_sk_fork(racc_sk_t *out, const racc_sk_t *sk, size_t n);
+
+//  Consistency check: true iff "sk" and "ref" have the same public key and
+//  their shares decode to the same secret. Does not exit early.
+bool racc_core_sk_check(const racc_sk_t *sk, const racc_sk_t *ref);
+
+//  ZeroEncoding(d): fill "z" with a fresh d-sharing of zero.
+void racc_zero_encoding(int64_t z[RACC_D][RACC_N], mask_random_t *mrg);
+
+//  Verification in two parts; racc_core_verify() is part 1 followed by
+//  part 2. Part 1 (CheckBounds, w') does not depend on the message, so it
+//  can run while "mu" is being computed. Part 1 returns false if
+//  CheckBounds fails, part 2 returns true iff the challenge hash matches.
+bool racc_core_verify_w(int64_t vw[RACC_K][RACC_N],
+                        const racc_sig_t *sig, const racc_pk_t *pk,
+                        const int64_t (*a)[RACC_ELL][RACC_N]);
+bool racc_core_verify_mu(   const int64_t vw[RACC_K][RACC_N],
+                            const racc_sig_t *sig,
+                            const uint8_t mu[RACC_MU_SZ]);
+
+//  ExpandA(seed) into "a" (NTT domain), K * ELL polynomials. A verifier
+//  that keeps "a" with the public key can pass it to racc_core_verify_a()
+//  or racc_core_verify_w() instead of NULL and skip the expansion.
+void racc_expand_a( int64_t a[RACC_K][RACC_ELL][RACC_N],
+                    const uint8_t seed[RACC_AS_SZ]);
+bool racc_core_verify_a(const racc_sig_t *sig,
+                        const uint8_t mu[RACC_MU_SZ],
+                        const racc_pk_t *pk,
+                        const int64_t (*a)[RACC_ELL][RACC_N]);
+
+//  === Signing statistics (racc_api.c) ===
+
+//  histogram size for attempts per signature; last bin counts the rest
+#define RACC_STAT_HIST 16
+
+//  signature attempt counters of a thread
+typedef struct {
+    uint64_t sig;                           //  signatures created
+    uint64_t bound_fail;                    //  rejected by CheckBounds
+    uint64_t enc_fail;                      //  rejected by encoding overflow
+    uint64_t hist[RACC_STAT_HIST];          //  hist[i]: i+1 attempts
+    int last_bound, last_enc;               //  rejections in last signature
+} racc_sign_stat_t;
+
+//  Copy the signing statistics of the calling thread to "st" (if not NULL)
+//  and reset them if "clear" is set.
+void racc_sign_stat(racc_sign_stat_t *st, bool clear);
+
+//  === Pipelined verification (racc_api.c) ===
+
+//  messages of at least this many bytes are hashed in parallel
+#ifndef RACC_PIPE_MIN
+#define RACC_PIPE_MIN (64 * 1024)
+#endif
+
+//  Verify a detached signature "sig" (CRYPTO_BYTES) on message "m" of
+//  "mlen" bytes under public key "pk". For long messages the lattice part
+//  runs on a second thread while the message is hashed. Returns 0 if the
+//  signature is valid, -1 otherwise (like crypto_sign_open).
+int racc_verify_pipe(   const uint8_t *sig, const uint8_t *m, size_t mlen,
+                        const uint8_t *pk);
+
+//  === Batch key generation and signing (racc_api.c) ===
+
+//  worker thread stack: a decoded secret key (and matrix A when signing)
+//  plus the keygen or signing frames
+#ifndef RACC_BATCH_STACK
+#define RACC_BATCH_STACK (16 << 20)
+#endif
+
+//  Generate "n" keypairs into "pk" (n * CRYPTO_PUBLICKEYBYTES) and "sk"
+//  (n * CRYPTO_SECRETKEYBYTES), encoded as by crypto_sign_keypair(). The
+//  batch is split over "nthr" threads (the caller and nthr - 1 workers),
+//  each with its own mask random generator and a randombytes() DRBG
+//  seeded from the caller's; nthr <= 1 runs in the calling thread, with
+//  the same output as "n" calls to crypto_sign_keypair(). Returns 0, or
+//  -1 if a key could not be encoded.
+int racc_keygen_batch(uint8_t *pk, uint8_t *sk, size_t n, int nthr);
+
+//  Create detached signatures "sig" (n * CRYPTO_BYTES, zero padded as in
+//  crypto_sign) of messages "m[i]" of "mlen[i]" bytes under encoded secret
+//  keys "sk[i]". Consecutive items with the same key pointer share its
+//  decoding and ExpandA. The batch is split over "nthr" threads as in
+//  racc_keygen_batch(). Each part keeps a decoded key and its matrix A
+//  (RACC_K * RACC_ELL * RACC_N * 8 bytes, up to 252 kB) on the stack of
+//  its thread, in addition to the signing frames; workers get
+//  RACC_BATCH_STACK, and the calling thread needs as much. Returns 0, or
+//  -1 if a key could not be decoded (its signatures are zeroed).
+int racc_sign_batch(uint8_t *sig, const uint8_t *const m[],
+                    const size_t mlen[], const uint8_t *const sk[],
+                    size_t n, int nthr);
+
 #ifdef __cplusplus
 }
 #endif
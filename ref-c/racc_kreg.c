@@ -0,0 +1,260 @@
+//  racc_kreg.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Registry of decoded (and expanded) public keys for verifiers.
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "racc_kreg.h"
+#include "racc_serial.h"
+#include "xof_sample.h"
+
+//  pin value of a slot that is being written
+#define KR_EXCL (INT_MIN / 2)
+
+//  Create a registry for at least "cap" keys. With "expand" each key also
+//  keeps its matrix A in NTT domain (K * ELL * N * 8 bytes per key).
+//  Return 0 on success, -1 if out of memory.
+
+int racc_kreg_init(racc_kreg_t *kr, size_t cap, bool expand)
+{
+    size_t i, n;
+
+    kr->nset = 1;
+    while (kr->nset * RACC_KR_WAYS < cap)
+        kr->nset <<= 1;
+    n = kr->nset * RACC_KR_WAYS;
+
+    kr->ent = calloc(n, sizeof(racc_kreg_ent_t));
+    kr->hand = calloc(kr->nset, 1);
+    kr->a = expand ? calloc(n, sizeof(kr->a[0])) : NULL;
+    if (kr->ent == NULL || kr->hand == NULL || (expand && kr->a == NULL)) {
+        free(kr->ent);
+        free(kr->hand);
+        free(kr->a);
+        return -1;
+    }
+
+    for (i = 0; i < n; i++) {
+        atomic_init(&kr->ent[i].pin, 0);
+        atomic_init(&kr->ent[i].tag, 0);
+        atomic_init(&kr->ent[i].ref, false);
+        kr->ent[i].a = expand ? (const int64_t (*)[RACC_ELL][RACC_N])
+                                    kr->a[i] : NULL;
+    }
+    for (i = 0; i < RACC_KR_LOCKS; i++) {
+        pthread_mutex_init(&kr->lock[i], NULL);
+    }
+    atomic_init(&kr->hit, 0);
+    atomic_init(&kr->miss, 0);
+    atomic_init(&kr->ins, 0);
+    atomic_init(&kr->evn, 0);
+
+    return 0;
+}
+
+//  Release the memory of registry "kr". No key may be in use.
+
+void racc_kreg_free(racc_kreg_t *kr)
+{
+    size_t i;
+
+    for (i = 0; i < RACC_KR_LOCKS; i++) {
+        pthread_mutex_destroy(&kr->lock[i]);
+    }
+    free(kr->ent);
+    free(kr->hand);
+    free(kr->a);
+    kr->ent = NULL;
+    kr->hand = NULL;
+    kr->a = NULL;
+    kr->nset = 0;
+}
+
+//  64-bit hash of an encoded public key (not cryptographic; a match is
+//  confirmed by comparing the encoding). Never 0.
+
+uint64_t racc_pk_hash(const uint8_t *pk)
+{
+    size_t i;
+    uint64_t x, h;
+
+    h = CRYPTO_PUBLICKEYBYTES;
+    for (i = 0; i + 8 <= CRYPTO_PUBLICKEYBYTES; i += 8) {
+        memcpy(&x, pk + i, 8);
+        h = (h ^ x) * 0x9E3779B97F4A7C15llu;
+        h ^= h >> 29;
+    }
+    for (; i < CRYPTO_PUBLICKEYBYTES; i++) {
+        h = (h ^ pk[i]) * 0x9E3779B97F4A7C15llu;
+    }
+    h ^= h >> 32;
+
+    return h != 0 ? h : 1;
+}
+
+//  pin the slot of set "i" that holds "pk" (hash "h"), or return NULL
+
+static racc_kreg_ent_t *kr_find(racc_kreg_t *kr, size_t i, uint64_t h,
+                                const uint8_t *pk)
+{
+    int j;
+    racc_kreg_ent_t *e;
+
+    for (j = 0; j < RACC_KR_WAYS; j++) {
+        e = &kr->ent[i * RACC_KR_WAYS + j];
+        if (atomic_load_explicit(&e->tag, memory_order_relaxed) != h)
+            continue;
+
+        //  pinned: the slot can not change until racc_kreg_put()
+        if (atomic_fetch_add_explicit(&e->pin, 1, memory_order_acquire) >= 0 &&
+            atomic_load_explicit(&e->tag, memory_order_relaxed) == h &&
+            memcmp(e->b, pk, CRYPTO_PUBLICKEYBYTES) == 0) {
+            atomic_store_explicit(&e->ref, true, memory_order_relaxed);
+            return e;
+        }
+        atomic_fetch_sub_explicit(&e->pin, 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+//  Find (or decode and register) the encoded public key "pk". The returned
+//  entry stays valid until racc_kreg_put(). Returns NULL if "pk" does not
+//  decode or all slots of its set are in use.
+
+const racc_kreg_ent_t *racc_kreg_get(racc_kreg_t *kr, const uint8_t *pk)
+{
+    size_t i;
+    int j, k;
+    uint64_t h;
+    bool ev;
+    racc_kreg_ent_t *e;
+    racc_pk_t r_pk;
+
+    h = racc_pk_hash(pk);
+    i = (size_t) (h >> 7) & (kr->nset - 1);
+
+    //  lock-free lookup
+    e = kr_find(kr, i, h, pk);
+    if (e != NULL) {
+        atomic_fetch_add_explicit(&kr->hit, 1, memory_order_relaxed);
+        return e;
+    }
+    atomic_fetch_add_explicit(&kr->miss, 1, memory_order_relaxed);
+
+    //  decode before claiming a slot: a bad key must not evict a good one
+    if (CRYPTO_PUBLICKEYBYTES != racc_decode_pk(&r_pk, pk))
+        return NULL;
+
+    pthread_mutex_lock(&kr->lock[i % RACC_KR_LOCKS]);
+
+    //  another thread may have registered it
+    e = kr_find(kr, i, h, pk);
+    if (e != NULL) {
+        pthread_mutex_unlock(&kr->lock[i % RACC_KR_LOCKS]);
+        return e;
+    }
+
+    //  CLOCK: skip referenced slots once, and slots that are in use
+    for (k = 0; k < 2 * RACC_KR_WAYS; k++) {
+        j = kr->hand[i];
+        kr->hand[i] = (j + 1) % RACC_KR_WAYS;
+        e = &kr->ent[i * RACC_KR_WAYS + j];
+        if (atomic_exchange_explicit(&e->ref, false, memory_order_relaxed))
+            continue;
+        j = 0;
+        if (atomic_compare_exchange_strong(&e->pin, &j, KR_EXCL))
+            break;
+    }
+    if (k == 2 * RACC_KR_WAYS) {
+        pthread_mutex_unlock(&kr->lock[i % RACC_KR_LOCKS]);
+        return NULL;
+    }
+
+    //  (re)fill the slot
+    ev = atomic_load_explicit(&e->tag, memory_order_relaxed) != 0;
+    atomic_store_explicit(&e->tag, 0, memory_order_relaxed);
+    memcpy(e->b, pk, CRYPTO_PUBLICKEYBYTES);
+    e->pk = r_pk;
+    if (e->a != NULL)
+        racc_expand_a(kr->a[e - kr->ent], e->pk.a_seed);
+
+    //  publish, pinned for the caller
+    atomic_store_explicit(&e->tag, h, memory_order_relaxed);
+    atomic_fetch_add_explicit(&e->pin, 1 - KR_EXCL, memory_order_acq_rel);
+
+    pthread_mutex_unlock(&kr->lock[i % RACC_KR_LOCKS]);
+
+    atomic_fetch_add_explicit(&kr->ins, 1, memory_order_relaxed);
+    if (ev)
+        atomic_fetch_add_explicit(&kr->evn, 1, memory_order_relaxed);
+
+    return e;
+}
+
+//  Release an entry returned by racc_kreg_get().
+
+void racc_kreg_put(const racc_kreg_ent_t *e)
+{
+    atomic_fetch_sub_explicit(&((racc_kreg_ent_t *) e)->pin, 1,
+                              memory_order_release);
+}
+
+//  Copy the counters of "kr" to "st".
+
+void racc_kreg_stat(racc_kreg_stat_t *st, racc_kreg_t *kr)
+{
+    st->hit = atomic_load(&kr->hit);
+    st->miss = atomic_load(&kr->miss);
+    st->ins = atomic_load(&kr->ins);
+    st->evn = atomic_load(&kr->evn);
+    st->cap = kr->nset * RACC_KR_WAYS;
+    st->mem = st->cap * sizeof(racc_kreg_ent_t) + kr->nset;
+    if (kr->a != NULL)
+        st->mem += st->cap * sizeof(kr->a[0]);
+}
+
+//  crypto_sign_open() with the public key taken from registry "kr".
+
+int racc_kreg_open( racc_kreg_t *kr,
+                    unsigned char *m, unsigned long long *mlen,
+                    const unsigned char *sm, unsigned long long smlen,
+                    const unsigned char *pk)
+{
+    const racc_kreg_ent_t *e;
+    racc_pk_t   r_pk;           //  internal-format public key (fallback)
+    racc_sig_t  r_sig;          //  internal-format signature
+    size_t      m_sz;
+    uint8_t     mu[RACC_MU_SZ];
+    bool        ok;
+
+    if (smlen < CRYPTO_BYTES ||
+        CRYPTO_BYTES != racc_decode_sig(&r_sig, sm))
+        return -1;
+    m_sz = smlen - CRYPTO_BYTES;
+
+    e = racc_kreg_get(kr, pk);
+    if (e != NULL) {
+        xof_chal_mu(mu, e->pk.tr, sm + CRYPTO_BYTES, m_sz);
+        ok = racc_core_verify_a(&r_sig, mu, &e->pk, e->a);
+        racc_kreg_put(e);
+    } else {
+
+        //  malformed key, or its set is busy
+        if (CRYPTO_PUBLICKEYBYTES != racc_decode_pk(&r_pk, pk))
+            return -1;
+        xof_chal_mu(mu, r_pk.tr, sm + CRYPTO_BYTES, m_sz);
+        ok = racc_core_verify(&r_sig, mu, &r_pk);
+    }
+    if (!ok)
+        return -1;
+
+    //  store the length and move the "opened" message
+    memcpy(m, sm + CRYPTO_BYTES, m_sz);
+    *mlen = m_sz;
+
+    return  0;
+}
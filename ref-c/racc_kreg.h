@@ -0,0 +1,106 @@
+//  racc_kreg.h
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Registry of decoded (and expanded) public keys for verifiers.
+
+#ifndef _RACC_KREG_H_
+#define _RACC_KREG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "racc_core.h"
+#include "api.h"
+
+//  === Global namespace prefix
+
+#ifdef RACC_
+#define racc_kreg_init RACC_(kreg_init)
+#define racc_kreg_free RACC_(kreg_free)
+#define racc_kreg_get RACC_(kreg_get)
+#define racc_kreg_put RACC_(kreg_put)
+#define racc_kreg_stat RACC_(kreg_stat)
+#define racc_kreg_open RACC_(kreg_open)
+#define racc_pk_hash RACC_(pk_hash)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Keys are found by a 64-bit hash of the encoded public key and confirmed
+//  by comparing the encoding itself, so lookups never compute tr. Slots
+//  are grouped in sets of RACC_KR_WAYS with CLOCK eviction. Readers do not
+//  lock: a reader "pins" a slot with an atomic count, and a slot is only
+//  rewritten once no reader holds it.
+
+#define RACC_KR_WAYS    4           //  slots per set
+#define RACC_KR_LOCKS   64          //  lock stripes (insertion only)
+
+//  one registered key
+typedef struct {
+    atomic_int pin;                         //  readers; < 0 while written
+    atomic_uint_fast64_t tag;               //  hash of b (0: empty)
+    atomic_bool ref;                        //  CLOCK reference bit
+    uint8_t b[CRYPTO_PUBLICKEYBYTES];       //  encoded key
+    racc_pk_t pk;                           //  decoded key
+    const int64_t (*a)[RACC_ELL][RACC_N];   //  ExpandA(seed) or NULL
+} racc_kreg_ent_t;
+
+//  registry
+typedef struct {
+    racc_kreg_ent_t *ent;                   //  slots
+    int64_t (*a)[RACC_K][RACC_ELL][RACC_N]; //  expanded A per slot or NULL
+    size_t nset;                            //  number of sets (2^n)
+    uint8_t *hand;                          //  CLOCK hand per set
+    pthread_mutex_t lock[RACC_KR_LOCKS];    //  set i uses lock[i % LOCKS]
+    atomic_uint_fast64_t hit, miss;         //  lookups
+    atomic_uint_fast64_t ins, evn;          //  insertions, evictions
+} racc_kreg_t;
+
+//  counters
+typedef struct {
+    uint64_t hit, miss;                     //  lookups
+    uint64_t ins, evn;                      //  insertions, evictions
+    size_t cap;                             //  capacity in keys
+    size_t mem;                             //  bytes allocated
+} racc_kreg_stat_t;
+
+//  Create a registry for at least "cap" keys. With "expand" each key also
+//  keeps its matrix A in NTT domain (K * ELL * N * 8 bytes per key).
+//  Return 0 on success, -1 if out of memory.
+int racc_kreg_init(racc_kreg_t *kr, size_t cap, bool expand);
+
+//  Release the memory of registry "kr". No key may be in use.
+void racc_kreg_free(racc_kreg_t *kr);
+
+//  Find (or decode and register) the encoded public key "pk". The returned
+//  entry stays valid until racc_kreg_put(). Returns NULL if "pk" does not
+//  decode or all slots of its set are in use.
+const racc_kreg_ent_t *racc_kreg_get(racc_kreg_t *kr, const uint8_t *pk);
+
+//  Release an entry returned by racc_kreg_get().
+void racc_kreg_put(const racc_kreg_ent_t *e);
+
+//  Copy the counters of "kr" to "st".
+void racc_kreg_stat(racc_kreg_stat_t *st, racc_kreg_t *kr);
+
+//  64-bit hash of an encoded public key (not cryptographic; a match must
+//  be confirmed by comparing the encoding). Never 0.
+uint64_t racc_pk_hash(const uint8_t *pk);
+
+//  crypto_sign_open() with the public key taken from registry "kr".
+int racc_kreg_open( racc_kreg_t *kr,
+                    unsigned char *m, unsigned long long *mlen,
+                    const unsigned char *sm, unsigned long long smlen,
+                    const unsigned char *pk);
+
+#ifdef __cplusplus
+}
+#endif
+
+//  _RACC_KREG_H_
+#endif
@@ -0,0 +1,327 @@
+//  racc_kstore.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Memory-mapped store of precomputed public keys for verifiers.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "racc_kstore.h"
+#include "racc_kreg.h"
+#include "racc_serial.h"
+#include "xof_sample.h"
+#include "sha3_t.h"
+
+//  byte order marker
+#define KS_ORDER 0x0102030405060708llu
+
+//  round "x" up to a multiple of "a" (a power of 2)
+#define KS_ALIGN(x, a) (((x) + (a) - 1) & ~((size_t) (a) - 1))
+
+#ifdef POLYR_Q32
+#define KS_BUILD RACC_KS_Q32
+#else
+#define KS_BUILD 0
+#endif
+
+//  header checksum covers everything before h_sum
+
+static void ks_hdr_sum(uint8_t h[RACC_KS_SUM], const racc_kstore_hdr_t *hdr)
+{
+    shake256(h, RACC_KS_SUM, (const uint8_t *) hdr,
+             offsetof(racc_kstore_hdr_t, h_sum));
+}
+
+//  index order
+
+static int ks_idx_cmp(const void *a, const void *b)
+{
+    const racc_kstore_idx_t *x = (const racc_kstore_idx_t *) a;
+    const racc_kstore_idx_t *y = (const racc_kstore_idx_t *) b;
+
+    if (x->h != y->h)
+        return x->h < y->h ? -1 : 1;
+    return x->i < y->i ? -1 : (x->i > y->i ? 1 : 0);
+}
+
+//  write "sz" bytes to "f" and absorb them into the data checksum
+
+static bool ks_put(FILE *f, sha3_t *kec, const void *buf, size_t sz)
+{
+    sha3_absorb(kec, (const uint8_t *) buf, sz);
+    return fwrite(buf, 1, sz, f) == sz;
+}
+
+//  Write the "n" >= 1 encoded public keys "pk" (n * CRYPTO_PUBLICKEYBYTES)
+//  to a new store "path", with ExpandA(seed) if "expand" is set.
+//  Return 0 on success, -1 on error (bad key or I/O; errno is set for I/O).
+
+int racc_kstore_write(  const char *path, const uint8_t *pk, size_t n,
+                        bool expand)
+{
+    size_t i, a_off, idx_sz;
+    bool ok;
+    FILE *f;
+    sha3_t kec;
+    racc_kstore_hdr_t hdr;
+    racc_kstore_idx_t *idx;
+    racc_kstore_rec_t *rec;
+    uint8_t *buf;
+
+    if (n == 0)
+        return -1;
+
+    //  layout
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, RACC_KS_MAGIC, sizeof(hdr.magic));
+    hdr.version = RACC_KS_VERSION;
+    hdr.flags = KS_BUILD | (expand ? RACC_KS_A : 0);
+    hdr.order = KS_ORDER;
+    snprintf(hdr.name, sizeof(hdr.name), "%s", CRYPTO_ALGNAME);
+    hdr.pk_sz = CRYPTO_PUBLICKEYBYTES;
+    hdr.rec_sz = sizeof(racc_kstore_rec_t);
+    a_off = KS_ALIGN(sizeof(racc_kstore_rec_t), 64);
+    hdr.stride = expand ?
+        KS_ALIGN(a_off + sizeof(int64_t[RACC_K][RACC_ELL][RACC_N]), 64) :
+        KS_ALIGN(sizeof(racc_kstore_rec_t), 64);
+    hdr.n = n;
+    idx_sz = n * sizeof(racc_kstore_idx_t);
+    hdr.idx_off = RACC_KS_PAGE;
+    hdr.rec_off = hdr.idx_off + KS_ALIGN(idx_sz, RACC_KS_PAGE);
+    hdr.file_sz = hdr.rec_off + KS_ALIGN(n * hdr.stride, RACC_KS_PAGE);
+
+    //  index (and padding to the record section)
+    idx = calloc(KS_ALIGN(idx_sz, RACC_KS_PAGE), 1);
+    buf = calloc(KS_ALIGN(hdr.stride, RACC_KS_PAGE), 1);
+    if (idx == NULL || buf == NULL) {
+        free(idx);
+        free(buf);
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        idx[i].h = racc_pk_hash(pk + i * CRYPTO_PUBLICKEYBYTES);
+        idx[i].i = i;
+    }
+    qsort(idx, n, sizeof(racc_kstore_idx_t), ks_idx_cmp);
+
+    f = fopen(path, "wb");
+    if (f == NULL) {
+        free(idx);
+        free(buf);
+        return -1;
+    }
+
+    //  header page is written last
+    sha3_init(&kec, SHAKE256_RATE);
+    ok = fwrite(buf, 1, RACC_KS_PAGE, f) == RACC_KS_PAGE &&
+         ks_put(f, &kec, idx, hdr.rec_off - hdr.idx_off);
+
+    //  records
+    rec = (racc_kstore_rec_t *) buf;
+    for (i = 0; ok && i < n; i++) {
+        memset(buf, 0, hdr.stride);
+        memcpy(rec->b, pk + i * CRYPTO_PUBLICKEYBYTES, CRYPTO_PUBLICKEYBYTES);
+        if (CRYPTO_PUBLICKEYBYTES != racc_decode_pk(&rec->pk, rec->b)) {
+            ok = false;
+            break;
+        }
+        if (expand)
+            racc_expand_a((int64_t (*)[RACC_ELL][RACC_N]) (buf + a_off),
+                          rec->pk.a_seed);
+        ok = ks_put(f, &kec, buf, hdr.stride);
+    }
+
+    //  padding of the last page
+    if (ok) {
+        memset(buf, 0, hdr.stride);
+        ok = ks_put(f, &kec, buf,
+                    hdr.file_sz - hdr.rec_off - n * hdr.stride);
+    }
+
+    //  checksums and header
+    sha3_pad(&kec, SHAKE_PAD);
+    sha3_squeeze(&kec, hdr.d_sum, RACC_KS_SUM);
+    ks_hdr_sum(hdr.h_sum, &hdr);
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 &&
+         fwrite(&hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+    ok = (fclose(f) == 0) && ok;
+
+    free(idx);
+    free(buf);
+    if (!ok)
+        remove(path);
+
+    return ok ? 0 : -1;
+}
+
+//  Map store "path" read-only. Header fields and the header checksum are
+//  always checked; "check" also checks the data checksum (reads the whole
+//  file). Return 0 on success, -1 on error.
+
+int racc_kstore_open(racc_kstore_t *ks, const char *path, bool check)
+{
+    int fd;
+    bool ok;
+    size_t sz, a_sz;
+    struct stat st;
+    void *p;
+    const racc_kstore_hdr_t *hdr;
+    uint8_t sum[RACC_KS_SUM];
+
+    memset(ks, 0, sizeof(racc_kstore_t));
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < RACC_KS_PAGE) {
+        close(fd);
+        return -1;
+    }
+    sz = (size_t) st.st_size;
+    p = mmap(NULL, sz, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return -1;
+    hdr = (const racc_kstore_hdr_t *) p;
+
+    //  format, build, and layout
+    a_sz = (hdr->flags & RACC_KS_A) ?
+        KS_ALIGN(sizeof(racc_kstore_rec_t), 64) +
+        sizeof(int64_t[RACC_K][RACC_ELL][RACC_N]) : sizeof(racc_kstore_rec_t);
+    ks_hdr_sum(sum, hdr);
+    ok = memcmp(hdr->magic, RACC_KS_MAGIC, sizeof(hdr->magic)) == 0 &&
+         hdr->version == RACC_KS_VERSION &&
+         hdr->order == KS_ORDER &&
+         (hdr->flags & RACC_KS_Q32) == KS_BUILD &&
+         strncmp(hdr->name, CRYPTO_ALGNAME, sizeof(hdr->name)) == 0 &&
+         hdr->pk_sz == CRYPTO_PUBLICKEYBYTES &&
+         hdr->rec_sz == sizeof(racc_kstore_rec_t) &&
+         hdr->stride >= a_sz && hdr->stride % 64 == 0 &&
+         hdr->idx_off == RACC_KS_PAGE &&
+         hdr->rec_off % RACC_KS_PAGE == 0 &&
+         hdr->file_sz == sz &&
+         //  (no products or sums of header fields that could wrap)
+         hdr->idx_off <= hdr->rec_off && hdr->rec_off <= hdr->file_sz &&
+         hdr->n <= (hdr->rec_off - hdr->idx_off) /
+                   sizeof(racc_kstore_idx_t) &&
+         hdr->n <= (hdr->file_sz - hdr->rec_off) / hdr->stride &&
+         memcmp(sum, hdr->h_sum, RACC_KS_SUM) == 0;
+
+    //  optional full check
+    if (ok && check) {
+        shake256(sum, RACC_KS_SUM, (const uint8_t *) p + hdr->idx_off,
+                 sz - hdr->idx_off);
+        ok = memcmp(sum, hdr->d_sum, RACC_KS_SUM) == 0;
+    }
+    if (!ok) {
+        munmap(p, sz);
+        return -1;
+    }
+
+    ks->hdr = hdr;
+    ks->idx = (const racc_kstore_idx_t *) ((const uint8_t *) p +
+                                           hdr->idx_off);
+    ks->rec = (const uint8_t *) p + hdr->rec_off;
+    ks->n = hdr->n;
+    ks->stride = hdr->stride;
+    ks->a_off = (hdr->flags & RACC_KS_A) ?
+                KS_ALIGN(sizeof(racc_kstore_rec_t), 64) : 0;
+    ks->map_sz = sz;
+
+    return 0;
+}
+
+//  Unmap an open store.
+
+void racc_kstore_close(racc_kstore_t *ks)
+{
+    if (ks->hdr != NULL)
+        munmap((void *) ks->hdr, ks->map_sz);
+    memset(ks, 0, sizeof(racc_kstore_t));
+}
+
+//  Find the encoded public key "pk"; NULL if it is not in the store.
+
+const racc_kstore_rec_t *racc_kstore_find(  const racc_kstore_t *ks,
+                                            const uint8_t *pk)
+{
+    size_t lo, hi, mid;
+    uint64_t h;
+    const racc_kstore_rec_t *r;
+
+    h = racc_pk_hash(pk);
+
+    //  first index entry with hash >= h
+    lo = 0;
+    hi = ks->n;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (ks->idx[mid].h < h)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (; lo < ks->n && ks->idx[lo].h == h; lo++) {
+        if (ks->idx[lo].i >= ks->n)
+            break;
+        r = (const racc_kstore_rec_t *) (ks->rec +
+                                         ks->idx[lo].i * ks->stride);
+        if (memcmp(r->b, pk, CRYPTO_PUBLICKEYBYTES) == 0)
+            return r;
+    }
+
+    return NULL;
+}
+
+//  ExpandA(seed) of record "r", or NULL if the store has none.
+
+const int64_t (*racc_kstore_a(  const racc_kstore_t *ks,
+                                const racc_kstore_rec_t *r))
+                                [RACC_ELL][RACC_N]
+{
+    if (ks->a_off == 0)
+        return NULL;
+
+    return (const int64_t (*)[RACC_ELL][RACC_N])
+                ((const uint8_t *) r + ks->a_off);
+}
+
+//  crypto_sign_open() with the public key taken from store "ks"; keys that
+//  are not in the store are decoded as usual.
+
+int racc_kstore_sign_open(  const racc_kstore_t *ks,
+                            unsigned char *m, unsigned long long *mlen,
+                            const unsigned char *sm,
+                            unsigned long long smlen,
+                            const unsigned char *pk)
+{
+    const racc_kstore_rec_t *r;
+    racc_sig_t  r_sig;          //  internal-format signature
+    size_t      m_sz;
+    uint8_t     mu[RACC_MU_SZ];
+
+    r = racc_kstore_find(ks, pk);
+    if (r == NULL)
+        return crypto_sign_open(m, mlen, sm, smlen, pk);
+
+    if (smlen < CRYPTO_BYTES ||
+        CRYPTO_BYTES != racc_decode_sig(&r_sig, sm))
+        return -1;
+    m_sz = smlen - CRYPTO_BYTES;
+
+    xof_chal_mu(mu, r->pk.tr, sm + CRYPTO_BYTES, m_sz);
+    if (!racc_core_verify_a(&r_sig, mu, &r->pk, racc_kstore_a(ks, r)))
+        return -1;
+
+    //  store the length and move the "opened" message
+    memcpy(m, sm + CRYPTO_BYTES, m_sz);
+    *mlen = m_sz;
+
+    return  0;
+}
@@ -0,0 +1,121 @@
+//  racc_kstore.h
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Memory-mapped store of precomputed public keys for verifiers.
+
+#ifndef _RACC_KSTORE_H_
+#define _RACC_KSTORE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "racc_core.h"
+#include "api.h"
+
+//  === Global namespace prefix
+
+#ifdef RACC_
+#define racc_kstore_write RACC_(kstore_write)
+#define racc_kstore_open RACC_(kstore_open)
+#define racc_kstore_close RACC_(kstore_close)
+#define racc_kstore_find RACC_(kstore_find)
+#define racc_kstore_a RACC_(kstore_a)
+#define racc_kstore_sign_open RACC_(kstore_sign_open)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  File layout; all offsets are multiples of RACC_KS_PAGE:
+//      header      one page, racc_kstore_hdr_t
+//      index       n x racc_kstore_idx_t, sorted by racc_pk_hash()
+//      records     n x "stride" bytes: racc_kstore_rec_t, then (with
+//                  RACC_KS_A) ExpandA(seed) at the next 64-byte boundary
+//  Records are stored in the in-memory layout of this build, so a store
+//  only opens in a build with the same parameters, polynomial backend,
+//  and byte order; racc_kstore_open() checks this.
+
+#define RACC_KS_MAGIC   "RACCKST"   //  8 bytes with the NUL
+#define RACC_KS_VERSION 1
+#define RACC_KS_PAGE    4096
+#define RACC_KS_SUM     32          //  SHAKE256 checksum size
+
+//  flags
+#define RACC_KS_A       0x01        //  records include ExpandA(seed)
+#define RACC_KS_Q32     0x02        //  POLYR_Q32 build
+
+typedef struct {
+    char magic[8];                          //  RACC_KS_MAGIC
+    uint32_t version;                       //  RACC_KS_VERSION
+    uint32_t flags;                         //  RACC_KS_A, RACC_KS_Q32
+    uint64_t order;                         //  0x0102030405060708
+    char name[32];                          //  CRYPTO_ALGNAME
+    uint64_t pk_sz;                         //  CRYPTO_PUBLICKEYBYTES
+    uint64_t rec_sz;                        //  sizeof(racc_kstore_rec_t)
+    uint64_t stride;                        //  bytes per record
+    uint64_t n;                             //  number of keys
+    uint64_t idx_off, rec_off, file_sz;     //  layout
+    uint8_t d_sum[RACC_KS_SUM];             //  SHAKE256(index, records)
+    uint8_t h_sum[RACC_KS_SUM];             //  SHAKE256(fields above)
+} racc_kstore_hdr_t;
+
+typedef struct {
+    uint64_t h;                             //  racc_pk_hash(b)
+    uint64_t i;                             //  record number
+} racc_kstore_idx_t;
+
+typedef struct {
+    racc_pk_t pk;                           //  decoded key, with tr
+    uint8_t b[CRYPTO_PUBLICKEYBYTES];       //  encoded key
+} racc_kstore_rec_t;
+
+//  an open (mapped) store
+typedef struct {
+    const racc_kstore_hdr_t *hdr;           //  mapped file
+    const racc_kstore_idx_t *idx;           //  index
+    const uint8_t *rec;                     //  first record
+    size_t n;                               //  number of keys
+    size_t stride;                          //  bytes per record
+    size_t a_off;                           //  offset of A in a record
+    size_t map_sz;                          //  mapped bytes
+} racc_kstore_t;
+
+//  Write the "n" >= 1 encoded public keys "pk" (n * CRYPTO_PUBLICKEYBYTES)
+//  to a new store "path", with ExpandA(seed) if "expand" is set.
+//  Return 0 on success, -1 on error (bad key or I/O; errno is set for I/O).
+int racc_kstore_write(  const char *path, const uint8_t *pk, size_t n,
+                        bool expand);
+
+//  Map store "path" read-only. Header fields and the header checksum are
+//  always checked; "check" also checks the data checksum (reads the whole
+//  file). Return 0 on success, -1 on error.
+int racc_kstore_open(racc_kstore_t *ks, const char *path, bool check);
+
+//  Unmap an open store.
+void racc_kstore_close(racc_kstore_t *ks);
+
+//  Find the encoded public key "pk"; NULL if it is not in the store.
+const racc_kstore_rec_t *racc_kstore_find(  const racc_kstore_t *ks,
+                                            const uint8_t *pk);
+
+//  ExpandA(seed) of record "r", or NULL if the store has none.
+const int64_t (*racc_kstore_a(  const racc_kstore_t *ks,
+                                const racc_kstore_rec_t *r))
+                                [RACC_ELL][RACC_N];
+
+//  crypto_sign_open() with the public key taken from store "ks"; keys that
+//  are not in the store are decoded as usual.
+int racc_kstore_sign_open(  const racc_kstore_t *ks,
+                            unsigned char *m, unsigned long long *mlen,
+                            const unsigned char *sm,
+                            unsigned long long smlen,
+                            const unsigned char *pk);
+
+#ifdef __cplusplus
+}
+#endif
+
+//  _RACC_KSTORE_H_
+#endif
@@ -0,0 +1,134 @@
+//  racc_prof.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Optional per-phase cycle profiler (compile with -DRACC_PROFILE).
+
+#ifdef RACC_PROFILE
+
+#include <stdio.h>
+#include <string.h>
+
+#include "racc_prof.h"
+
+//  counters of the calling thread
+
+PLAT_TLS racc_prof_t racc_prof;
+
+//  phase names
+
+const char *racc_prof_name[RACC_PROF_NUM] = {
+    "KeyGen()",     "  ZeroEncoding",   "  AddRepNoise",    "  NTT",
+    "  ExpandA",    "  A*s",            "  Decode+round",
+
+    "Sign()",       "  ExpandA",        "  ZeroEncoding",   "  AddRepNoise",
+    "  NTT",        "  A*r A*z c*t",    "  Decode+round+h", "  ChalHash",
+    "  ChalPoly",   "  Refresh",        "  c*s+r Decode",   "  CheckBounds",
+    "  (rejected)",
+
+    "Verify()",     "  CheckBounds",    "  ChalPoly",       "  NTT",
+    "  ExpandA",    "  A*z c*t",        "  round+h",        "  ChalHash"
+};
+
+//  clear the counters of the calling thread (the event hook is kept)
+
+void racc_prof_reset()
+{
+    racc_prof_ev_t ev_read = racc_prof.ev_read;
+
+    memset(&racc_prof, 0, sizeof(racc_prof_t));
+    racc_prof.ev_read = ev_read;
+}
+
+//  external events at start of an operation
+
+void racc_prof_ev_begin()
+{
+    racc_prof.ev_read(racc_prof.ev_lap);
+    memcpy(racc_prof.ev_beg, racc_prof.ev_lap, sizeof(racc_prof.ev_beg));
+}
+
+//  charge external events since the last lap to phase "ph"
+
+void racc_prof_ev_lap(racc_prof_ph_t ph)
+{
+    size_t i;
+    uint64_t ev[RACC_PROF_EV];
+
+    racc_prof.ev_read(ev);
+    for (i = 0; i < RACC_PROF_EV; i++) {
+        racc_prof.ev[ph][i] += ev[i] - racc_prof.ev_lap[i];
+        racc_prof.ev_lap[i] = ev[i];
+    }
+}
+
+//  charge external events of the whole operation to phase "ph"
+
+void racc_prof_ev_end(racc_prof_ph_t ph)
+{
+    size_t i;
+    uint64_t ev[RACC_PROF_EV];
+
+    racc_prof.ev_read(ev);
+    for (i = 0; i < RACC_PROF_EV; i++) {
+        racc_prof.ev[ph][i] += ev[i] - racc_prof.ev_beg[i];
+    }
+}
+
+//  accumulate counters "src" into "dst"
+
+void racc_prof_add(racc_prof_t *dst, const racc_prof_t *src)
+{
+    size_t i, j;
+
+    for (i = 0; i < RACC_PROF_NUM; i++) {
+        dst->cyc[i] += src->cyc[i];
+        dst->cnt[i] += src->cnt[i];
+        dst->kec[i] += src->kec[i];
+        dst->mrg[i] += src->mrg[i];
+        for (j = 0; j < RACC_PROF_EV; j++) {
+            dst->ev[i][j] += src->ev[i][j];
+        }
+    }
+}
+
+//  print a table of "prof", normalized per operation
+
+void racc_prof_print(const racc_prof_t *prof)
+{
+    size_t i;
+    double ops, tot;
+
+    ops = 1.0;
+    tot = 1.0;
+
+    printf("%-18s %12s %7s %9s %9s %9s\n", "phase",
+           "kcyc/op", "%", "laps/op", "keccak/op", "mask/op");
+
+    for (i = 0; i < RACC_PROF_NUM; i++) {
+
+        //  a new operation: the totals are the denominators
+        if (i == RACC_PROF_KG_ALL || i == RACC_PROF_SG_ALL ||
+            i == RACC_PROF_VF_ALL) {
+            if (prof->cnt[i] == 0) {
+                while (i + 1 < RACC_PROF_NUM &&
+                       racc_prof_name[i + 1][0] == ' ') {
+                    i++;
+                }
+                continue;
+            }
+            ops = (double) prof->cnt[i];
+            tot = (double) prof->cyc[i];
+        }
+
+        printf("%-18s %12.1f %6.2f%% %9.2f %9.1f %9.1f\n",
+               racc_prof_name[i],
+               1E-3 * ((double) prof->cyc[i]) / ops,
+               100.0 * ((double) prof->cyc[i]) / tot,
+               ((double) prof->cnt[i]) / ops,
+               ((double) prof->kec[i]) / ops,
+               ((double) prof->mrg[i]) / ops);
+    }
+}
+
+//  RACC_PROFILE
+#endif
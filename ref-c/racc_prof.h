@@ -0,0 +1,163 @@
+//  racc_prof.h
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Optional per-phase cycle profiler (compile with -DRACC_PROFILE).
+
+#ifndef _RACC_PROF_H_
+#define _RACC_PROF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "plat_local.h"
+#include "keccakf1600.h"
+
+//  instrumented phases of keygen, sign, and verify
+typedef enum {
+    RACC_PROF_KG_ALL,       //  racc_core_keygen() total
+    RACC_PROF_KG_ZENC,      //  ZeroEncoding
+    RACC_PROF_KG_NOISE,     //  AddRepNoise
+    RACC_PROF_KG_NTT,       //  forward and inverse NTTs
+    RACC_PROF_KG_EXPA,      //  ExpandA
+    RACC_PROF_KG_MMUL,      //  A * [[s]] pointwise products
+    RACC_PROF_KG_ROUND,     //  Decode and rounding of t
+
+    RACC_PROF_SG_ALL,       //  racc_core_sign() total
+    RACC_PROF_SG_EXPA,      //  ExpandA
+    RACC_PROF_SG_ZENC,      //  ZeroEncoding
+    RACC_PROF_SG_NOISE,     //  AddRepNoise
+    RACC_PROF_SG_NTT,       //  forward and inverse NTTs
+    RACC_PROF_SG_MMUL,      //  A * [[r]], A * z, c * t pointwise products
+    RACC_PROF_SG_ROUND,     //  Decode, rounding of w, and the hint h
+    RACC_PROF_SG_CHASH,     //  ChalHash
+    RACC_PROF_SG_CPOLY,     //  ChalPoly
+    RACC_PROF_SG_REFRESH,   //  Refresh of [[s]] and [[r]]
+    RACC_PROF_SG_RESP,      //  [[z]] = c * [[s]] + [[r]] and its Decode
+    RACC_PROF_SG_BOUNDS,    //  CheckBounds
+    RACC_PROF_SG_REJECT,    //  attempts rejected by CheckBounds
+
+    RACC_PROF_VF_ALL,       //  racc_core_verify() total
+    RACC_PROF_VF_BOUNDS,    //  CheckBounds
+    RACC_PROF_VF_CPOLY,     //  ChalPoly
+    RACC_PROF_VF_NTT,       //  forward and inverse NTTs
+    RACC_PROF_VF_EXPA,      //  ExpandA
+    RACC_PROF_VF_MMUL,      //  A * z, c * t pointwise products
+    RACC_PROF_VF_ROUND,     //  rounding and hint addition
+    RACC_PROF_VF_CHASH,     //  ChalHash
+
+    RACC_PROF_NUM
+} racc_prof_ph_t;
+
+//  external event counters (e.g. perf_event_open) per phase
+#define RACC_PROF_EV 5
+
+//  hook that reads the current external event counts
+typedef void (*racc_prof_ev_t)(uint64_t *ev);
+
+//  per-thread counters
+typedef struct {
+    uint64_t cyc[RACC_PROF_NUM];            //  cycles
+    uint64_t cnt[RACC_PROF_NUM];            //  number of laps
+    uint64_t kec[RACC_PROF_NUM];            //  Keccak permutations
+    uint64_t mrg[RACC_PROF_NUM];            //  mask random calls
+    uint64_t mask;                          //  running event count
+    uint64_t t_lap, t_beg, t_mark;          //  timestamps
+    uint64_t kec_lap, mrg_lap;              //  event counts at last lap
+    uint64_t kec_beg, mrg_beg;              //  event counts at begin
+    uint64_t ev[RACC_PROF_NUM][RACC_PROF_EV];   //  external events
+    uint64_t ev_lap[RACC_PROF_EV];          //  external counts at last lap
+    uint64_t ev_beg[RACC_PROF_EV];          //  external counts at begin
+    racc_prof_ev_t ev_read;                 //  external hook (or NULL)
+} racc_prof_t;
+
+#ifdef RACC_PROFILE
+
+//  counters of the calling thread
+extern PLAT_TLS racc_prof_t racc_prof;
+
+//  phase names
+extern const char *racc_prof_name[RACC_PROF_NUM];
+
+//  clear the counters of the calling thread (the event hook is kept)
+void racc_prof_reset();
+
+//  accumulate counters "src" into "dst"
+void racc_prof_add(racc_prof_t *dst, const racc_prof_t *src);
+
+//  print a table of "prof", normalized per operation
+void racc_prof_print(const racc_prof_t *prof);
+
+//  external events: start of operation / lap / end of operation
+void racc_prof_ev_begin();
+void racc_prof_ev_lap(racc_prof_ph_t ph);
+void racc_prof_ev_end(racc_prof_ph_t ph);
+
+//  charge everything since the last lap to phase "ph"
+
+static inline void racc_prof_lap(racc_prof_ph_t ph)
+{
+    uint64_t t = plat_get_cycle();
+
+    racc_prof.cyc[ph] += t - racc_prof.t_lap;
+    racc_prof.cnt[ph]++;
+    racc_prof.kec[ph] += keccak_count - racc_prof.kec_lap;
+    racc_prof.mrg[ph] += racc_prof.mask - racc_prof.mrg_lap;
+    racc_prof.kec_lap = keccak_count;
+    racc_prof.mrg_lap = racc_prof.mask;
+    if (racc_prof.ev_read != NULL)
+        racc_prof_ev_lap(ph);
+    racc_prof.t_lap = plat_get_cycle();
+}
+
+//  start of an operation; laps are counted from here
+#define RACC_PROF_BEGIN() {                     \
+    if (racc_prof.ev_read != NULL)              \
+        racc_prof_ev_begin();                   \
+    racc_prof.t_beg = plat_get_cycle();         \
+    racc_prof.t_lap = racc_prof.t_beg;          \
+    racc_prof.kec_lap = keccak_count;           \
+    racc_prof.mrg_lap = racc_prof.mask;         \
+    racc_prof.kec_beg = keccak_count;           \
+    racc_prof.mrg_beg = racc_prof.mask;         \
+}
+
+//  end of an operation; total time goes to phase "ph"
+#define RACC_PROF_END(ph) {                                 \
+    racc_prof.cyc[ph] += plat_get_cycle() - racc_prof.t_beg;\
+    racc_prof.cnt[ph]++;                                    \
+    racc_prof.kec[ph] += keccak_count - racc_prof.kec_beg;  \
+    racc_prof.mrg[ph] += racc_prof.mask - racc_prof.mrg_beg;\
+    if (racc_prof.ev_read != NULL)                          \
+        racc_prof_ev_end(ph);                               \
+}
+
+//  set a mark / charge time since the mark to phase "ph"
+#define RACC_PROF_MARK()    { racc_prof.t_mark = plat_get_cycle(); }
+#define RACC_PROF_SINCE(ph) {                               \
+    racc_prof.cyc[ph] += plat_get_cycle() - racc_prof.t_mark;\
+    racc_prof.cnt[ph]++;                                    \
+}
+
+#define RACC_PROF_LAP(ph)   racc_prof_lap(ph)
+#define RACC_PROF_COUNT(x)  { racc_prof.x++; }
+
+#else
+
+//  not profiling: no-ops
+#define RACC_PROF_BEGIN()
+#define RACC_PROF_END(ph)
+#define RACC_PROF_MARK()
+#define RACC_PROF_SINCE(ph)
+#define RACC_PROF_LAP(ph)
+#define RACC_PROF_COUNT(x)
+
+//  RACC_PROFILE
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+//  _RACC_PROF_H_
+#endif
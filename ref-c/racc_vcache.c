@@ -0,0 +1,245 @@
+//  racc_vcache.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Bounded cache of verified signatures.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "api.h"
+#include "racc_vcache.h"
+#include "racc_core.h"
+#include "racc_serial.h"
+#include "xof_sample.h"
+#include "sha3_t.h"
+
+//  domain separator of cache keys
+#define VC_DOMAIN 'V'
+
+//  Create a cache for at least "cap" entries with policy "evict".
+//  Return 0 on success, -1 if out of memory.
+
+int racc_vcache_init(racc_vcache_t *vc, size_t cap, racc_vc_evict_t evict)
+{
+    size_t i;
+
+    vc->nset = 1;
+    while (vc->nset * RACC_VC_WAYS < cap)
+        vc->nset <<= 1;
+    vc->evict = evict;
+
+    vc->set = calloc(vc->nset, sizeof(racc_vc_set_t));
+    if (vc->set == NULL)
+        return -1;
+
+    for (i = 0; i < RACC_VC_LOCKS; i++) {
+        pthread_mutex_init(&vc->lock[i], NULL);
+    }
+    atomic_init(&vc->hit, 0);
+    atomic_init(&vc->miss, 0);
+    atomic_init(&vc->ins, 0);
+    atomic_init(&vc->evn, 0);
+
+    return 0;
+}
+
+//  Release the memory of cache "vc".
+
+void racc_vcache_free(racc_vcache_t *vc)
+{
+    size_t i;
+
+    for (i = 0; i < RACC_VC_LOCKS; i++) {
+        pthread_mutex_destroy(&vc->lock[i]);
+    }
+    free(vc->set);
+    vc->set = NULL;
+    vc->nset = 0;
+}
+
+//  Remove all entries and reset the counters.
+
+void racc_vcache_clear(racc_vcache_t *vc)
+{
+    size_t i;
+
+    for (i = 0; i < RACC_VC_LOCKS; i++) {
+        pthread_mutex_lock(&vc->lock[i]);
+    }
+    memset(vc->set, 0, vc->nset * sizeof(racc_vc_set_t));
+    atomic_store(&vc->hit, 0);
+    atomic_store(&vc->miss, 0);
+    atomic_store(&vc->ins, 0);
+    atomic_store(&vc->evn, 0);
+    for (i = 0; i < RACC_VC_LOCKS; i++) {
+        pthread_mutex_unlock(&vc->lock[i]);
+    }
+}
+
+//  Compute the cache key of an encoded signature "sig" (CRYPTO_BYTES) on
+//  message hash "mu" under a public key with hash "tr".
+
+void racc_vcache_key(   uint8_t key[RACC_VC_KEY], const uint8_t tr[],
+                        const uint8_t mu[], const uint8_t *sig)
+{
+    sha3_t kec;
+    uint8_t ds = VC_DOMAIN;
+
+    sha3_init(&kec, SHAKE256_RATE);
+    sha3_absorb(&kec, &ds, 1);
+    sha3_absorb(&kec, tr, RACC_TR_SZ);
+    sha3_absorb(&kec, mu, RACC_MU_SZ);
+    sha3_absorb(&kec, sig, CRYPTO_BYTES);
+    sha3_pad(&kec, SHAKE_PAD);
+    sha3_squeeze(&kec, key, RACC_VC_KEY);
+}
+
+//  set index of a key (keys are uniform)
+
+static inline size_t vc_index(const racc_vcache_t *vc,
+                              const uint8_t key[RACC_VC_KEY])
+{
+    uint64_t x;
+
+    memcpy(&x, key, sizeof(x));
+
+    return (size_t) x & (vc->nset - 1);
+}
+
+//  way of "key" in set "s", or -1
+
+static int vc_way(const racc_vc_set_t *s, const uint8_t key[RACC_VC_KEY])
+{
+    int i;
+
+    for (i = 0; i < RACC_VC_WAYS; i++) {
+        if (((s->used >> i) & 1) &&
+            memcmp(s->key[i], key, RACC_VC_KEY) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+//  Look up "key"; a hit marks the entry as recently used.
+
+bool racc_vcache_find(racc_vcache_t *vc, const uint8_t key[RACC_VC_KEY])
+{
+    size_t i;
+    int w;
+
+    i = vc_index(vc, key);
+    pthread_mutex_lock(&vc->lock[i % RACC_VC_LOCKS]);
+    w = vc_way(&vc->set[i], key);
+    if (w >= 0)
+        vc->set[i].ref |= 1 << w;
+    pthread_mutex_unlock(&vc->lock[i % RACC_VC_LOCKS]);
+
+    if (w >= 0)
+        atomic_fetch_add_explicit(&vc->hit, 1, memory_order_relaxed);
+    else
+        atomic_fetch_add_explicit(&vc->miss, 1, memory_order_relaxed);
+
+    return w >= 0;
+}
+
+//  Record "key" as verified, evicting an entry of its set if full.
+
+void racc_vcache_insert(racc_vcache_t *vc, const uint8_t key[RACC_VC_KEY])
+{
+    size_t i;
+    int w;
+    bool ev;
+    racc_vc_set_t *s;
+
+    i = vc_index(vc, key);
+    s = &vc->set[i];
+    ev = false;
+
+    pthread_mutex_lock(&vc->lock[i % RACC_VC_LOCKS]);
+
+    //  another thread may have verified the same signature
+    if (vc_way(s, key) >= 0) {
+        pthread_mutex_unlock(&vc->lock[i % RACC_VC_LOCKS]);
+        return;
+    }
+
+    if (s->used != (1 << RACC_VC_WAYS) - 1) {
+
+        //  free way
+        for (w = 0; (s->used >> w) & 1; w++)
+            ;
+    } else {
+
+        //  victim: CLOCK skips (and clears) referenced entries
+        if (vc->evict == RACC_VC_CLOCK) {
+            while ((s->ref >> s->hand) & 1) {
+                s->ref &= ~(1 << s->hand);
+                s->hand = (s->hand + 1) % RACC_VC_WAYS;
+            }
+        }
+        w = s->hand;
+        s->hand = (s->hand + 1) % RACC_VC_WAYS;
+        ev = true;
+    }
+
+    memcpy(s->key[w], key, RACC_VC_KEY);
+    s->used |= 1 << w;
+    s->ref &= ~(1 << w);
+
+    pthread_mutex_unlock(&vc->lock[i % RACC_VC_LOCKS]);
+
+    atomic_fetch_add_explicit(&vc->ins, 1, memory_order_relaxed);
+    if (ev)
+        atomic_fetch_add_explicit(&vc->evn, 1, memory_order_relaxed);
+}
+
+//  Copy the counters of "vc" to "st".
+
+void racc_vcache_stat(racc_vcache_stat_t *st, racc_vcache_t *vc)
+{
+    st->hit = atomic_load(&vc->hit);
+    st->miss = atomic_load(&vc->miss);
+    st->ins = atomic_load(&vc->ins);
+    st->evn = atomic_load(&vc->evn);
+    st->cap = vc->nset * RACC_VC_WAYS;
+    st->mem = vc->nset * sizeof(racc_vc_set_t);
+}
+
+//  crypto_sign_open() that answers repeated (pk, message, signature)
+//  tuples from "vc" and records new valid ones in it.
+
+int racc_vcache_open(   racc_vcache_t *vc,
+                        unsigned char *m, unsigned long long *mlen,
+                        const unsigned char *sm, unsigned long long smlen,
+                        const unsigned char *pk)
+{
+    racc_pk_t   r_pk;           //  internal-format public key
+    racc_sig_t  r_sig;          //  internal-format signature
+    size_t      m_sz;
+    uint8_t     mu[RACC_MU_SZ];
+    uint8_t     key[RACC_VC_KEY];
+
+    //  the public key hash tr is needed for mu
+    if (smlen < CRYPTO_BYTES ||
+        CRYPTO_PUBLICKEYBYTES != racc_decode_pk(&r_pk, pk))
+        return -1;
+    m_sz = smlen - CRYPTO_BYTES;
+
+    xof_chal_mu(mu, r_pk.tr, sm + CRYPTO_BYTES, m_sz);
+    racc_vcache_key(key, r_pk.tr, mu, sm);
+
+    //  full verification of new tuples
+    if (!racc_vcache_find(vc, key)) {
+        if (CRYPTO_BYTES != racc_decode_sig(&r_sig, sm) ||
+            !racc_core_verify(&r_sig, mu, &r_pk))
+            return -1;
+        racc_vcache_insert(vc, key);
+    }
+
+    //  store the length and move the "opened" message
+    memcpy(m, sm + CRYPTO_BYTES, m_sz);
+    *mlen = m_sz;
+
+    return  0;
+}
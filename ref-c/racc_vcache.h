@@ -0,0 +1,110 @@
+//  racc_vcache.h
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === Bounded cache of verified signatures.
+
+#ifndef _RACC_VCACHE_H_
+#define _RACC_VCACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "racc_param.h"
+
+//  === Global namespace prefix
+
+#ifdef RACC_
+#define racc_vcache_init RACC_(vcache_init)
+#define racc_vcache_free RACC_(vcache_free)
+#define racc_vcache_clear RACC_(vcache_clear)
+#define racc_vcache_key RACC_(vcache_key)
+#define racc_vcache_find RACC_(vcache_find)
+#define racc_vcache_insert RACC_(vcache_insert)
+#define racc_vcache_stat RACC_(vcache_stat)
+#define racc_vcache_open RACC_(vcache_open)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  The cache only holds positive results: the digest of (tr, mu, encoded
+//  signature) of a signature that passed racc_core_verify(). Entries live
+//  in sets of RACC_VC_WAYS; the set index is taken from the digest.
+
+#define RACC_VC_KEY     RACC_CRH    //  digest size in bytes
+#define RACC_VC_WAYS    8           //  entries per set (bits of a byte)
+#define RACC_VC_LOCKS   64          //  lock stripes
+
+//  eviction policy within a set
+typedef enum {
+    RACC_VC_CLOCK,                  //  second chance (approximate LRU)
+    RACC_VC_FIFO                    //  oldest insertion first
+} racc_vc_evict_t;
+
+//  one set
+typedef struct {
+    uint8_t key[RACC_VC_WAYS][RACC_VC_KEY]; //  digests
+    uint8_t used;                           //  valid bits
+    uint8_t ref;                            //  reference bits (CLOCK)
+    uint8_t hand;                           //  next way to consider
+} racc_vc_set_t;
+
+//  cache
+typedef struct {
+    racc_vc_set_t *set;                     //  sets
+    size_t nset;                            //  number of sets (2^n)
+    racc_vc_evict_t evict;                  //  eviction policy
+    pthread_mutex_t lock[RACC_VC_LOCKS];    //  set i uses lock[i % LOCKS]
+    atomic_uint_fast64_t hit, miss;         //  lookups
+    atomic_uint_fast64_t ins, evn;          //  insertions, evictions
+} racc_vcache_t;
+
+//  counters
+typedef struct {
+    uint64_t hit, miss;                     //  lookups
+    uint64_t ins, evn;                      //  insertions, evictions
+    size_t cap;                             //  capacity in entries
+    size_t mem;                             //  bytes allocated
+} racc_vcache_stat_t;
+
+//  Create a cache for at least "cap" entries with policy "evict".
+//  Return 0 on success, -1 if out of memory.
+int racc_vcache_init(racc_vcache_t *vc, size_t cap, racc_vc_evict_t evict);
+
+//  Release the memory of cache "vc".
+void racc_vcache_free(racc_vcache_t *vc);
+
+//  Remove all entries and reset the counters.
+void racc_vcache_clear(racc_vcache_t *vc);
+
+//  Compute the cache key of an encoded signature "sig" (CRYPTO_BYTES) on
+//  message hash "mu" under a public key with hash "tr".
+void racc_vcache_key(   uint8_t key[RACC_VC_KEY], const uint8_t tr[],
+                        const uint8_t mu[], const uint8_t *sig);
+
+//  Look up "key"; a hit marks the entry as recently used.
+bool racc_vcache_find(racc_vcache_t *vc, const uint8_t key[RACC_VC_KEY]);
+
+//  Record "key" as verified, evicting an entry of its set if full.
+void racc_vcache_insert(racc_vcache_t *vc, const uint8_t key[RACC_VC_KEY]);
+
+//  Copy the counters of "vc" to "st".
+void racc_vcache_stat(racc_vcache_stat_t *st, racc_vcache_t *vc);
+
+//  crypto_sign_open() that answers repeated (pk, message, signature)
+//  tuples from "vc" and records new valid ones in it.
+int racc_vcache_open(   racc_vcache_t *vc,
+                        unsigned char *m, unsigned long long *mlen,
+                        const unsigned char *sm, unsigned long long smlen,
+                        const unsigned char *pk);
+
+#ifdef __cplusplus
+}
+#endif
+
+//  _RACC_VCACHE_H_
+#endif
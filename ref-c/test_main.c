@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "plat_local.h"
 #include "racc_core.h"
@@ -18,6 +19,11 @@
 #include "mont64.h"
 #include "polyr.h"
 #include "sha3_t.h"
+#include "racc_vcache.h"
+#include "racc_kreg.h"
+#include "racc_kstore.h"
+#include "aes_ni.h"
+#include "xof_sample.h"
 
 #include "api.h"
 
@@ -55,6 +61,30 @@ static inline double cpu_clock_secs()
     return ((double)clock()) / ((double)CLOCKS_PER_SEC);
 }
 
+//  [debug] rewrite "n" and "file_sz" (truncating the file) in the header
+//  of key store "fn", with a valid header checksum
+
+static void kst_patch(const char *fn, uint64_t n, uint64_t file_sz)
+{
+    FILE *f;
+    racc_kstore_hdr_t hdr;
+
+    f = fopen(fn, "r+b");
+    if (f == NULL)
+        return;
+    if (fread(&hdr, sizeof(hdr), 1, f) == 1) {
+        hdr.n = n;
+        hdr.file_sz = file_sz;
+        shake256(hdr.h_sum, RACC_KS_SUM, (const uint8_t *) &hdr,
+                 offsetof(racc_kstore_hdr_t, h_sum));
+        fseek(f, 0, SEEK_SET);
+        fwrite(&hdr, sizeof(hdr), 1, f);
+    }
+    fclose(f);
+    if (truncate(fn, file_sz) != 0)
+        perror(fn);
+}
+
 //  maximum message size
 #define MAX_MSG 256
 
@@ -94,6 +124,37 @@ int main()
     }
     nist_randombytes_init(seed, NULL, 256);
 
+#ifndef NIST_KAT
+    //  === DRBG backends: identical output across counter carries ===
+    aes256_ctr_drbg_t drbg;
+    uint8_t aes_ref[1400], aes_out[1400];
+    const size_t aes_len[6] = { 1, 15, 17, 100, 261, 1000 };
+    size_t j, aes_pos;
+    int lvl, aes_max = aesni_level();
+
+    for (lvl = AESNI_NONE; lvl <= aes_max; lvl++) {
+        aesni_select(lvl);
+        aes256ctr_xof_init(&drbg, seed);
+        aes_pos = 0;
+        for (i = 0; i < 6; i++) {
+            //  low 32 or 64 bits of the counter wrap after 5 blocks
+            for (j = i % 2 == 0 ? 8 : 12; j < 16; j++) {
+                drbg.ctr[j] = 0xFF;
+            }
+            drbg.ctr[15] = 0xFA;
+            aes256ctr_xof(&drbg, aes_out + aes_pos, aes_len[i]);
+            aes_pos += aes_len[i];
+        }
+        if (lvl == AESNI_NONE) {
+            memcpy(aes_ref, aes_out, aes_pos);
+        } else if (memcmp(aes_ref, aes_out, aes_pos) != 0) {
+            printf("aesni backend %d differs\n", lvl);
+            fail++;
+        }
+    }
+    aesni_select(aes_max);
+#endif
+
     //  (start)
     printf("CRYPTO_ALGNAME\t= %s\n", CRYPTO_ALGNAME);
     printf("CRYPTO_PUBLICKEYBYTES\t= %d\n", CRYPTO_PUBLICKEYBYTES);
@@ -121,6 +182,122 @@ int main()
 
     printf("verify fail= %d\n", fail);
 
+    //  === verified-signature cache: miss, miss, hit ===
+    racc_vcache_t vc;
+    racc_vcache_stat_t vst;
+    if (racc_vcache_init(&vc, 64, RACC_VC_CLOCK) == 0) {
+        fail += racc_vcache_open(&vc, m2, &mlen2, sm, smlen, pk) != 0 ? 0 : 1;
+        sm[123]--;
+        fail += racc_vcache_open(&vc, m2, &mlen2, sm, smlen, pk) == 0 ? 0 : 1;
+        fail += racc_vcache_open(&vc, m2, &mlen2, sm, smlen, pk) == 0 ? 0 : 1;
+        fail += (mlen == mlen2 && memcmp(msg, m2, mlen) == 0) ? 0 : 1;
+        racc_vcache_stat(&vst, &vc);
+        fail += (vst.hit == 1 && vst.miss == 2 && vst.ins == 1) ? 0 : 1;
+        racc_vcache_free(&vc);
+    }
+    printf("vcache fail= %d\n", fail);
+
+    //  === public key registry, with expanded A: miss, hit ===
+    racc_kreg_t kr;
+    racc_kreg_stat_t kst;
+    if (racc_kreg_init(&kr, 16, true) == 0) {
+        fail += racc_kreg_open(&kr, m2, &mlen2, sm, smlen, pk) == 0 ? 0 : 1;
+        fail += racc_kreg_open(&kr, m2, &mlen2, sm, smlen, pk) == 0 ? 0 : 1;
+        racc_kreg_stat(&kst, &kr);
+        fail += (kst.hit == 1 && kst.miss == 1 && kst.ins == 1) ? 0 : 1;
+        sm[123]++;
+        fail += racc_kreg_open(&kr, m2, &mlen2, sm, smlen, pk) != 0 ? 0 : 1;
+        sm[123]--;
+        racc_kreg_free(&kr);
+    }
+    printf("kreg fail= %d\n", fail);
+
+    //  === precomputed key store: write, map, verify ===
+    racc_kstore_t ks;
+    uint64_t kst_n, kst_sz;
+    char ks_fn[] = "/tmp/xtest_kst_XXXXXX";
+    int ks_fd = mkstemp(ks_fn);
+    if (ks_fd >= 0) {
+        close(ks_fd);
+        fail += racc_kstore_write(ks_fn, pk, 1, true) == 0 ? 0 : 1;
+        if (racc_kstore_open(&ks, ks_fn, true) == 0) {
+            fail += racc_kstore_find(&ks, pk) != NULL ? 0 : 1;
+            fail += racc_kstore_sign_open(&ks, m2, &mlen2,
+                                          sm, smlen, pk) == 0 ? 0 : 1;
+            sm[123]++;
+            fail += racc_kstore_sign_open(&ks, m2, &mlen2,
+                                          sm, smlen, pk) != 0 ? 0 : 1;
+            sm[123]--;
+            kst_n = ks.n;
+            kst_sz = ks.map_sz;
+            racc_kstore_close(&ks);
+
+            //  expect rejection: n * sizeof(idx) and n * stride wrap to 0
+            kst_patch(ks_fn, kst_n + (1llu << 60), kst_sz);
+            fail += racc_kstore_open(&ks, ks_fn, false) != 0 ? 0 : 1;
+
+            //  expect rejection: records truncated (header says so too)
+            kst_patch(ks_fn, kst_n, kst_sz - RACC_KS_PAGE);
+            fail += racc_kstore_open(&ks, ks_fn, false) != 0 ? 0 : 1;
+        } else {
+            fail++;
+        }
+        remove(ks_fn);
+    }
+    printf("kstore fail= %d\n", fail);
+
+    //  === batch keygen: serial output as crypto_sign_keypair(); threads ===
+    uint8_t bpk[2][CRYPTO_PUBLICKEYBYTES], bsk[2][CRYPTO_SECRETKEYBYTES];
+    uint8_t gpk[2][CRYPTO_PUBLICKEYBYTES], gsk[2][CRYPTO_SECRETKEYBYTES];
+    nist_randombytes_init(seed, NULL, 256);
+    crypto_sign_keypair(bpk[0], bsk[0]);
+    crypto_sign_keypair(bpk[1], bsk[1]);
+    nist_randombytes_init(seed, NULL, 256);
+    fail += racc_keygen_batch(gpk[0], gsk[0], 2, 1);
+    fail += memcmp(gpk, bpk, sizeof(bpk)) == 0 &&
+            memcmp(gsk, bsk, sizeof(bsk)) == 0 ? 0 : 1;
+    fail += racc_keygen_batch(bpk[0], bsk[0], 2, 2);
+    for (i = 0; i < 2; i++) {
+        crypto_sign(sm, &smlen, msg, mlen, bsk[i]);
+        fail += crypto_sign_open(m2, &mlen2, sm, smlen, bpk[i]) == 0 ? 0 : 1;
+    }
+    printf("kgbatch fail= %d\n", fail);
+
+    //  === batch signing: same key twice, then another key; threads ===
+    uint8_t bsig[3][CRYPTO_BYTES];
+    const uint8_t *bm[3] = { msg, m2, msg };
+    const size_t bml[3] = { mlen, 1, mlen };
+    const uint8_t *bk[3] = { bsk[0], bsk[0], bsk[1] };
+    const uint8_t *bp[3] = { bpk[0], bpk[0], bpk[1] };
+    fail += racc_sign_batch(bsig[0], bm, bml, bk, 3, 2);
+    for (i = 0; i < 3; i++) {
+        fail += racc_verify_pipe(bsig[i], bm[i], bml[i], bp[i]) == 0 ? 0 : 1;
+    }
+    fail += racc_verify_pipe(bsig[2], bm[0], bml[0], bp[0]) != 0 ? 0 : 1;
+    printf("sgbatch fail= %d\n", fail);
+
+    //  === forked signing keys: same secret, sign, detect a change ===
+    racc_sk_t *fsk = malloc(3 * sizeof(racc_sk_t));
+    racc_sig_t *fsig = malloc(sizeof(racc_sig_t));
+    uint8_t fmu[RACC_MU_SZ];
+    if (fsk != NULL && fsig != NULL &&
+        racc_decode_sk(&fsk[2], sk) == CRYPTO_SECRETKEYBYTES) {
+        racc_core_sk_fork(fsk, &fsk[2], 2);
+        fail += racc_core_sk_check(&fsk[0], &fsk[2]) ? 0 : 1;
+        fail += racc_core_sk_check(&fsk[1], &fsk[2]) ? 0 : 1;
+        xof_chal_mu(fmu, fsk[0].pk.tr, msg, mlen);
+        racc_core_sign(fsig, fmu, &fsk[0]);
+        fail += racc_core_verify(fsig, fmu, &fsk[2].pk) ? 0 : 1;
+        fail += racc_core_sk_check(&fsk[0], &fsk[1]) ? 0 : 1;
+        fsk[1].s[0][0][0] ^= 1;
+        fail += racc_core_sk_check(&fsk[1], &fsk[2]) ? 1 : 0;
+    } else {
+        fail++;
+    }
+    free(fsk);
+    free(fsig);
+    printf("skfork fail= %d\n", fail);
+
 #ifdef BENCH_TIMEOUT
     to = BENCH_TIMEOUT;
 #else
@@ -0,0 +1,220 @@
+//  aes_ni.c
+//  Copyright (c) 2023 Raccoon Signature Team. See LICENSE.
+
+//  === AES-256 with x86-64 AES-NI / VAES instructions (runtime selected).
+//  Output is identical to test_aes1kt.c; the instructions have no
+//  data-dependent table lookups.
+
+#ifndef NIST_KAT
+
+#include "aes_ni.h"
+
+//  detected processor support (-1: not yet), and the upper limit; both
+//  are accessed atomically (detection may run in several threads at once)
+
+static int aesni_cpu = -1;
+static int aesni_max = AESNI_VAES;
+
+#ifdef AESNI_X64
+
+#include <immintrin.h>
+
+static int aesni_detect()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("vaes") && __builtin_cpu_supports("avx512f"))
+        return AESNI_VAES;
+    if (__builtin_cpu_supports("aes"))
+        return AESNI_AES;
+    return AESNI_NONE;
+}
+
+#else
+#define aesni_detect() AESNI_NONE
+#endif
+
+//  Backend used by the DRBG: the best one that the processor supports,
+//  limited to "max" (e.g. AESNI_NONE to force the portable code) once
+//  aesni_select() has been called. Returns the backend.
+
+int aesni_level()
+{
+    int cpu, max;
+
+    cpu = __atomic_load_n(&aesni_cpu, __ATOMIC_RELAXED);
+    if (cpu < 0) {
+        cpu = aesni_detect();
+        __atomic_store_n(&aesni_cpu, cpu, __ATOMIC_RELAXED);
+    }
+    max = __atomic_load_n(&aesni_max, __ATOMIC_RELAXED);
+
+    return cpu < max ? cpu : max;
+}
+
+int aesni_select(int max)
+{
+    __atomic_store_n(&aesni_max, max, __ATOMIC_RELAXED);
+
+    return aesni_level();
+}
+
+#ifdef AESNI_X64
+
+//  key expansion steps (Intel AES-NI white paper, AES-256)
+
+#define AESNI_TARGET __attribute__((target("aes,sse4.1")))
+
+AESNI_TARGET
+static inline __m128i kx_mix(__m128i k, __m128i t)
+{
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    return _mm_xor_si128(k, t);
+}
+
+#define KX_EVEN(i, rc) {                                            \
+    k[i] = kx_mix(k[i - 2], _mm_shuffle_epi32(                      \
+                    _mm_aeskeygenassist_si128(k[i - 1], rc), 0xFF)); }
+#define KX_ODD(i) {                                                 \
+    k[i] = kx_mix(k[i - 2], _mm_shuffle_epi32(                      \
+                    _mm_aeskeygenassist_si128(k[i - 1], 0), 0xAA)); }
+
+//  Same round key layout as aes256_enc_key() (bytes in memory order).
+
+AESNI_TARGET
+void aesni256_enc_key(uint32_t rk[AES256_RK_WORDS], const uint8_t key[32])
+{
+    int i;
+    __m128i k[AES256_ROUNDS + 1];
+
+    k[0] = _mm_loadu_si128((const __m128i *) key);
+    k[1] = _mm_loadu_si128((const __m128i *) (key + 16));
+    KX_EVEN(2, 0x01);   KX_ODD(3);
+    KX_EVEN(4, 0x02);   KX_ODD(5);
+    KX_EVEN(6, 0x04);   KX_ODD(7);
+    KX_EVEN(8, 0x08);   KX_ODD(9);
+    KX_EVEN(10, 0x10);  KX_ODD(11);
+    KX_EVEN(12, 0x20);  KX_ODD(13);
+    KX_EVEN(14, 0x40);
+
+    for (i = 0; i <= AES256_ROUNDS; i++) {
+        _mm_storeu_si128((__m128i *) (rk + 4 * i), k[i]);
+    }
+}
+
+//  encrypt "n" <= 8 blocks of "buf" in place
+
+AESNI_TARGET
+static void aesni_enc8(uint8_t *buf, size_t n,
+                       const uint32_t rk[AES256_RK_WORDS])
+{
+    size_t i, j;
+    __m128i k, x[8];
+
+    k = _mm_loadu_si128((const __m128i *) rk);
+    for (j = 0; j < n; j++) {
+        x[j] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)
+                                             (buf + 16 * j)), k);
+    }
+    for (i = 1; i < AES256_ROUNDS; i++) {
+        k = _mm_loadu_si128((const __m128i *) (rk + 4 * i));
+        for (j = 0; j < n; j++) {
+            x[j] = _mm_aesenc_si128(x[j], k);
+        }
+    }
+    k = _mm_loadu_si128((const __m128i *) (rk + 4 * AES256_ROUNDS));
+    for (j = 0; j < n; j++) {
+        _mm_storeu_si128((__m128i *) (buf + 16 * j),
+                         _mm_aesenclast_si128(x[j], k));
+    }
+}
+
+//  encrypt 16 blocks of "buf" in place, four per register
+
+__attribute__((target("vaes,avx512f")))
+static void vaes_enc16(uint8_t *buf, const uint32_t rk[AES256_RK_WORDS])
+{
+    int i;
+    __m512i k, x0, x1, x2, x3;
+
+    k = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) rk));
+    x0 = _mm512_xor_si512(_mm512_loadu_si512(buf), k);
+    x1 = _mm512_xor_si512(_mm512_loadu_si512(buf + 64), k);
+    x2 = _mm512_xor_si512(_mm512_loadu_si512(buf + 128), k);
+    x3 = _mm512_xor_si512(_mm512_loadu_si512(buf + 192), k);
+    for (i = 1; i < AES256_ROUNDS; i++) {
+        k = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)
+                                                   (rk + 4 * i)));
+        x0 = _mm512_aesenc_epi128(x0, k);
+        x1 = _mm512_aesenc_epi128(x1, k);
+        x2 = _mm512_aesenc_epi128(x2, k);
+        x3 = _mm512_aesenc_epi128(x3, k);
+    }
+    k = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)
+                                        (rk + 4 * AES256_ROUNDS)));
+    _mm512_storeu_si512(buf, _mm512_aesenclast_epi128(x0, k));
+    _mm512_storeu_si512(buf + 64, _mm512_aesenclast_epi128(x1, k));
+    _mm512_storeu_si512(buf + 128, _mm512_aesenclast_epi128(x2, k));
+    _mm512_storeu_si512(buf + 192, _mm512_aesenclast_epi128(x3, k));
+}
+
+//  write "n" successive big-endian counter blocks (after "hi:lo") to "buf"
+
+static inline void ctr_fill(uint8_t *buf, size_t n, uint64_t *hi, uint64_t *lo)
+{
+    size_t i;
+    uint64_t x;
+
+    for (i = 0; i < n; i++) {
+        (*lo)++;
+        if (*lo == 0)
+            (*hi)++;
+        x = __builtin_bswap64(*hi);
+        __builtin_memcpy(buf + 16 * i, &x, 8);
+        x = __builtin_bswap64(*lo);
+        __builtin_memcpy(buf + 16 * i + 8, &x, 8);
+    }
+}
+
+//  CTR mode: for each of "n" blocks, increment the 128-bit big-endian
+//  counter "ctr" and write its encryption to "out" (as in the NIST DRBG).
+
+void aesni256_ctr(  uint8_t *out, size_t n, uint8_t ctr[16],
+                    const uint32_t rk[AES256_RK_WORDS], int lvl)
+{
+    size_t m;
+    uint64_t hi, lo;
+
+    __builtin_memcpy(&hi, ctr, 8);
+    __builtin_memcpy(&lo, ctr + 8, 8);
+    hi = __builtin_bswap64(hi);
+    lo = __builtin_bswap64(lo);
+
+    if (lvl >= AESNI_VAES) {
+        while (n >= 16) {
+            ctr_fill(out, 16, &hi, &lo);
+            vaes_enc16(out, rk);
+            out += 16 * 16;
+            n -= 16;
+        }
+    }
+    while (n > 0) {
+        m = n < 8 ? n : 8;
+        ctr_fill(out, m, &hi, &lo);
+        aesni_enc8(out, m, rk);
+        out += 16 * m;
+        n -= m;
+    }
+
+    hi = __builtin_bswap64(hi);
+    lo = __builtin_bswap64(lo);
+    __builtin_memcpy(ctr, &hi, 8);
+    __builtin_memcpy(ctr + 8, &lo, 8);
+}
+
+//  AESNI_X64
+#endif
+
+//  NIST_KAT
+#endif
@@ -7,6 +7,10 @@
 #include "keccakf1600.h"
 #include "plat_local.h"
 
+#ifdef RACC_PROFILE
+PLAT_TLS uint64_t keccak_count = 0;
+#endif
+
 //  clear the state
 
 void keccak_clear(uint64_t vs[25])
@@ -60,7 +64,7 @@ void keccak_f1600(uint64_t vs[25])
     uint64_t sa, sb, sc, sd, se, sf, sg, sh, si, sj, sk, sl, sm, sn, so, sp, sq,
         sr, ss, st, su, sv, sw, sx, sy;
 
-    //  keccak_count++;
+    KECCAK_COUNT();
 
     //  load state, little endian, aligned
 
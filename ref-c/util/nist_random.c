@@ -8,11 +8,16 @@
 
 #include <string.h>
 #include "nist_random.h"
+#include "aes_ni.h"
 
 //  shared random generator
 
 aes256_ctr_drbg_t aesdrbg_global_ctx = {0};
 
+//  per-thread override (multi-threaded benchmarks and APIs)
+
+static PLAT_TLS aes256_ctr_drbg_t *aesdrbg_local_ctx = NULL;
+
 //  (not constant time )
 
 static inline void aesdrbg_inc_ctr(uint8_t ctr[16])
@@ -29,29 +34,59 @@ static inline void aesdrbg_inc_ctr(uint8_t ctr[16])
     }
 }
 
-static void aesdrbg_update(aes256_ctr_drbg_t *ctx, const uint8_t *input48)
+//  set the key schedule from ctx->key
+
+static void aesdrbg_key(aes256_ctr_drbg_t *ctx)
+{
+#ifdef AESNI_X64
+    if (aesni_level() != AESNI_NONE) {
+        aesni256_enc_key(ctx->rk, ctx->key);
+        return;
+    }
+#endif
+    aes256_enc_key(ctx->rk, ctx->key);
+}
+
+//  "n" blocks of counter mode output to "out"
+
+static void aesdrbg_ctr(aes256_ctr_drbg_t *ctx, uint8_t *out, size_t n)
 {
     size_t i;
-    uint8_t tmp[48];
 
-    for (i = 0; i < 48; i += 16) {
+#ifdef AESNI_X64
+    int lvl = aesni_level();
+    if (lvl != AESNI_NONE) {
+        aesni256_ctr(out, n, ctx->ctr, ctx->rk, lvl);
+        return;
+    }
+#endif
+    for (i = 0; i < n; i++) {
         aesdrbg_inc_ctr(ctx->ctr);
-        aes256_enc_ecb(tmp + i, ctx->ctr, ctx->rk);
+        aes256_enc_ecb(out + 16 * i, ctx->ctr, ctx->rk);
     }
+}
+
+static void aesdrbg_update(aes256_ctr_drbg_t *ctx, const uint8_t *input48)
+{
+    size_t i;
+    uint8_t tmp[48];
+
+    aesdrbg_ctr(ctx, tmp, 3);
     if (input48 != NULL) {
         for (i = 0; i < 48; i++)
             tmp[i] ^= input48[i];
     }
     memcpy(ctx->key, tmp, 32);
     memcpy(ctx->ctr, tmp + 32, 16);
-    aes256_enc_key(ctx->rk, ctx->key);
+    aesdrbg_key(ctx);
 }
 
 void aes256ctr_xof_init(aes256_ctr_drbg_t *ctx, const uint8_t *input48)
 {
     memset(ctx->key, 0x00, 32);
     memset(ctx->ctr, 0x00, 16);
-    aes256_enc_key(ctx->rk, ctx->key);
+    aes256ctr_buffer(ctx, false);
+    aesdrbg_key(ctx);
 
     aesdrbg_update(ctx, input48);
 }
@@ -62,21 +97,46 @@ int aes256ctr_xof(void *ctx, void *buf, size_t len)
     aes256_ctr_drbg_t *drbg = ctx;
     uint8_t *x = buf;
 
+    //  whole blocks directly to the output, then a partial one
+    aesdrbg_ctr(drbg, x, len / 16);
+    if (len % 16 != 0) {
+        aesdrbg_ctr(drbg, tmp, 1);
+        memcpy(x + (len & ~((size_t) 15)), tmp, len % 16);
+    }
+    aesdrbg_update(drbg, NULL);
+
+    return 0;
+}
+
+//  buffered mode on / off
+
+void aes256ctr_buffer(aes256_ctr_drbg_t *ctx, bool on)
+{
+    memset(ctx->res, 0x00, AESDRBG_RES_SZ);
+    ctx->res_i = AESDRBG_RES_SZ;
+    ctx->res_on = on;
+}
+
+//  serve "len" bytes from the reservoir, refilling it as needed
+
+static int aesdrbg_res(aes256_ctr_drbg_t *ctx, uint8_t *x, size_t len)
+{
+    size_t n;
+
     while (len > 0) {
-        // increment ctr
-        aesdrbg_inc_ctr(drbg->ctr);
-        aes256_enc_ecb(tmp, drbg->ctr, drbg->rk);
-
-        if (len > 15) {
-            memcpy(x, tmp, 16);
-            x += 16;
-            len -= 16;
-        } else {
-            memcpy(x, tmp, len);
-            len = 0;
+        if (ctx->res_i == AESDRBG_RES_SZ) {
+            aes256ctr_xof(ctx, ctx->res, AESDRBG_RES_SZ);
+            ctx->res_i = 0;
         }
+        n = AESDRBG_RES_SZ - ctx->res_i;
+        if (n > len)
+            n = len;
+        memcpy(x, ctx->res + ctx->res_i, n);
+        memset(ctx->res + ctx->res_i, 0x00, n);     //  wipe
+        ctx->res_i += n;
+        x += n;
+        len -= n;
     }
-    aesdrbg_update(drbg, NULL);
 
     return 0;
 }
@@ -104,7 +164,29 @@ void nist_randombytes_init(const uint8_t entropy_input[48],
 
 int nist_randombytes(uint8_t *x, size_t xlen)
 {
-    return aes256ctr_xof(&aesdrbg_global_ctx, x, xlen);
+    aes256_ctr_drbg_t *ctx = aesdrbg_local_ctx;
+
+    if (ctx == NULL) {
+        ctx = &aesdrbg_global_ctx;
+    }
+    if (ctx->res_on)
+        return aesdrbg_res(ctx, x, xlen);
+
+    return aes256ctr_xof(ctx, x, xlen);
+}
+
+//  use DRBG "ctx" for randombytes() in the calling thread (NULL: global)
+
+void nist_randombytes_ctx(aes256_ctr_drbg_t *ctx)
+{
+    aesdrbg_local_ctx = ctx;
+}
+
+//  DRBG set for the calling thread by nist_randombytes_ctx() (NULL: global)
+
+aes256_ctr_drbg_t *nist_randombytes_get_ctx()
+{
+    return aesdrbg_local_ctx;
 }
 
 //  NIST_KAT
@@ -17,21 +17,79 @@ void sha3_init(sha3_t* kec, size_t r)
     kec->r = r;
 }
 
+//  xor "n" bytes of "m" into the state at byte offset "i"
+
+static inline void sha3_xor(uint64_t s[25], size_t i,
+                            const uint8_t *m, size_t n)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    size_t j;
+    uint8_t *b = ((uint8_t *) s) + i;
+
+    for (j = 0; j < n; j++) {
+        b[j] ^= m[j];
+    }
+#else
+    while (n > 0 && (i & 7) != 0) {
+        s[i >> 3] ^= ((uint64_t) *m++) << (8 * (i & 7));
+        i++;
+        n--;
+    }
+    while (n >= 8) {
+        s[i >> 3] ^= get64u_le(m);
+        m += 8;
+        i += 8;
+        n -= 8;
+    }
+    while (n > 0) {
+        s[i >> 3] ^= ((uint64_t) *m++) << (8 * (i & 7));
+        i++;
+        n--;
+    }
+#endif
+}
+
+//  copy "n" bytes from the state at byte offset "i" to "h"
+
+static inline void sha3_get(uint8_t *h, const uint64_t s[25],
+                            size_t i, size_t n)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(h, ((const uint8_t *) s) + i, n);
+#else
+    while (n > 0 && (i & 7) != 0) {
+        *h++ = s[i >> 3] >> (8 * (i & 7));
+        i++;
+        n--;
+    }
+    while (n >= 8) {
+        put64u_le(h, s[i >> 3]);
+        h += 8;
+        i += 8;
+        n -= 8;
+    }
+    while (n > 0) {
+        *h++ = s[i >> 3] >> (8 * (i & 7));
+        i++;
+        n--;
+    }
+#endif
+}
+
 //  Absorb "m_sz" bytes from "m" into the Keccak context "kec".
 
 void sha3_absorb(sha3_t* kec, const uint8_t* m, size_t m_sz)
 {
     size_t l;
 
-    l = kec->r - kec->i;
-    if (m_sz < l) {
-        memcpy(kec->b + kec->i, m, m_sz);
-        kec->i += m_sz;
-        return;
-    }
     if (kec->i > 0) {
-        memcpy(kec->b + kec->i, m, l);
-        keccak_xorbytes(kec->s, kec->b, kec->r);
+        l = kec->r - kec->i;
+        if (m_sz < l) {
+            sha3_xor(kec->s, kec->i, m, m_sz);
+            kec->i += m_sz;
+            return;
+        }
+        sha3_xor(kec->s, kec->i, m, l);
         keccak_f1600(kec->s);
         m_sz -= l;
         m += l;
@@ -43,7 +101,7 @@ void sha3_absorb(sha3_t* kec, const uint8_t* m, size_t m_sz)
         m_sz -= kec->r;
         m += kec->r;
     }
-    memcpy(kec->b, m, m_sz);
+    sha3_xor(kec->s, 0, m, m_sz);
     kec->i = m_sz;
 }
 
@@ -51,10 +109,8 @@ void sha3_absorb(sha3_t* kec, const uint8_t* m, size_t m_sz)
 
 void sha3_pad(sha3_t* kec, uint8_t p)
 {
-    kec->b[kec->i++] = p;
-    memset(kec->b + kec->i, 0, kec->r - kec->i);
-    kec->b[kec->r - 1] |= 0x80;
-    keccak_xorbytes(kec->s, kec->b, kec->r);
+    kec->s[kec->i >> 3] ^= ((uint64_t) p) << (8 * (kec->i & 7));
+    kec->s[(kec->r - 1) >> 3] ^= 0x80ull << (8 * ((kec->r - 1) & 7));
     kec->i = kec->r;
 }
 
@@ -64,19 +120,26 @@ void sha3_squeeze(sha3_t* kec, uint8_t* h, size_t h_sz)
 {
     size_t l;
 
+    //  common case: a few bytes from the current block
+    if (h_sz <= kec->r - kec->i) {
+        sha3_get(h, kec->s, kec->i, h_sz);
+        kec->i += h_sz;
+        return;
+    }
+
     while (h_sz > 0) {
         if (kec->i >= kec->r) {
             keccak_f1600(kec->s);
-            keccak_extract(kec->s, kec->b, kec->r);
             kec->i = 0;
         }
         l = kec->r - kec->i;
-        if (h_sz <= l) {
-            memcpy(h, kec->b + kec->i, h_sz);
-            kec->i += h_sz;
-            return;
+        if (h_sz < l)
+            l = h_sz;
+        if (l == kec->r) {
+            keccak_extract(kec->s, h, kec->r);
+        } else {
+            sha3_get(h, kec->s, kec->i, l);
         }
-        memcpy(h, kec->b + kec->i, l);
         h += l;
         h_sz -= l;
         kec->i += l;
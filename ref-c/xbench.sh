@@ -0,0 +1,19 @@
+#!/bin/bash
+
+#	Multi-threaded throughput / latency benchmark over all parameter sets.
+#	Extra arguments are passed to xbench, e.g. ./xbench.sh -t 16 -H
+
+for dut in \
+	RACCOON_128_1	RACCOON_128_2	RACCOON_128_4	\
+	RACCOON_128_8	RACCOON_128_16	RACCOON_128_32	\
+	RACCOON_192_1	RACCOON_192_2	RACCOON_192_4	\
+	RACCOON_192_8	RACCOON_192_16	RACCOON_192_32	\
+	RACCOON_256_1	RACCOON_256_2	RACCOON_256_4	\
+	RACCOON_256_8	RACCOON_256_16	RACCOON_256_32
+do
+	logf=xbench_$dut.txt
+	echo === $logf ===
+	make obj-clean
+	make RACCF="-D"$dut" -DBENCH_TIMEOUT=2.0" xbench
+	./xbench "$@" | tee $logf
+done
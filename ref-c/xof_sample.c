@@ -49,34 +49,93 @@ void xof_sample_q(int64_t r[RACC_N], const uint8_t *seed, size_t seed_sz)
     }
 }
 
+//  Unpack "blen"-byte little-endian words from "buf" to "bits"-wide signed
+//  coefficients mod q. Inlined with constant "blen" for the widths in use
+//  so that the compiler turns the loop into vector shifts and masks; the
+//  8-byte loads may read up to 7 bytes past the last word.
+
+static inline __attribute__((always_inline))
+void sample_u_unpack(int64_t r[RACC_N], const uint8_t *buf,
+                     size_t blen, int bits)
+{
+    size_t i;
+    int64_t x, mask, mid;
+
+    mask = (1ll << bits) - 1;
+    mid = 1ll << (bits - 1);
+
+    for (i = 0; i < RACC_N; i++) {
+        x = get64u_le(buf + blen * i) & mask;
+        x ^= mid;  //   two's complement sign bit: 0=pos, 1=neg
+        r[i] = mont64_cadd(x - mid, RACC_Q);
+    }
+}
+
 //  Sample "bits"-wide signed coefficients from "seed[seed_sz]".
 //  The input seed is assumed to alredy contain domain separation.
+//  Coefficient i is taken from bytes [blen*i, blen*(i+1)) of the output
+//  stream, blen = ceil(bits/8); the stream is squeezed in one call.
 
 void xof_sample_u(int64_t r[RACC_N], int bits,
                   const uint8_t *seed, size_t seed_sz)
 {
-    size_t i, blen;
-    int64_t x, mask, mid;
-    uint8_t buf[8];
+    size_t blen;
+    uint8_t buf[8 * RACC_N + 8];
     sha3_t kec;
 
     blen = (bits + 7) / 8;
-    mask = (1ll << bits) - 1;
-    mid = 1ll << (bits - 1);
 
     //  absorb seed
     sha3_init(&kec, SHAKE256_RATE);
     sha3_absorb(&kec, seed, seed_sz);
     sha3_pad(&kec, SHAKE_PAD);
 
-    //  sample from squeezed outpu
-    memset(buf, 0, sizeof(buf));
-    for (i = 0; i < RACC_N; i++) {
-        sha3_squeeze(&kec, buf, blen);
-        x = get64u_le(buf) & mask;
-        x ^= mid;  //   two's complement sign bit: 0=pos, 1=neg
-        r[i] = mont64_cadd(x - mid, RACC_Q);
+    //  squeeze all RACC_N coefficients at once
+    sha3_squeeze(&kec, buf, blen * RACC_N);
+    memset(buf + blen * RACC_N, 0, 8);
+
+    //  RACC_UT is 4..7 bits, RACC_UW is 39..41 bits
+    switch (blen) {
+        case 1:
+            sample_u_unpack(r, buf, 1, bits);
+            break;
+        case 5:
+            sample_u_unpack(r, buf, 5, bits);
+            break;
+        case 6:
+            sample_u_unpack(r, buf, 6, bits);
+            break;
+        default:
+            sample_u_unpack(r, buf, blen, bits);
+            break;
+    }
+}
+
+//  bytes per coefficient of w in the challenge hash: ceil(log2(q_w)/8)
+#define CHAL_WB ((RACC_LGW + 7) / 8)
+
+//  Pack a row of w into CHAL_WB little-endian bytes per coefficient.
+
+static inline void chal_pack_w(uint8_t row[RACC_N * CHAL_WB],
+                               const int64_t wi[RACC_N])
+{
+    size_t j;
+#if CHAL_WB == 1
+    for (j = 0; j < RACC_N; j++) {
+        row[j] = (uint8_t) wi[j];
     }
+#else
+    size_t k;
+    uint64_t x;
+
+    for (j = 0; j < RACC_N; j++) {
+        x = (uint64_t) wi[j];
+        for (k = 0; k < CHAL_WB; k++) {
+            row[j * CHAL_WB + k] = (uint8_t) x;
+            x >>= 8;
+        }
+    }
+#endif
 }
 
 //  Hash "w" vector with "mu" to produce challenge hash "ch".
@@ -84,8 +143,9 @@ void xof_sample_u(int64_t r[RACC_N], int bits,
 void xof_chal_hash( uint8_t ch[RACC_CH_SZ], const uint8_t mu[RACC_MU_SZ],
                     const int64_t w[RACC_K][RACC_N])
 {
-    size_t i, j;
+    size_t i;
     uint8_t buf[8];
+    uint8_t row[RACC_N * CHAL_WB];
     sha3_t kec;
 
     sha3_init(&kec, SHAKE256_RATE);
@@ -99,16 +159,10 @@ void xof_chal_hash( uint8_t ch[RACC_CH_SZ], const uint8_t mu[RACC_MU_SZ],
     //  mu
     sha3_absorb(&kec, mu, RACC_MU_SZ);
 
-    //  w: ceil(log2(q)/8) bytes per coefficient
+    //  w: packed and absorbed one row at a time
     for (i = 0; i < RACC_K; i++) {
-        for (j = 0; j < RACC_N; j++) {
-#if ((RACC_LGW + 7) / 8) == 1
-            buf[0] = w[i][j];
-#else
-            put64u_le(buf, w[i][j]);
-#endif
-            sha3_absorb(&kec, buf, (RACC_LGW + 7) / 8);
-        }
+        chal_pack_w(row, w[i]);
+        sha3_absorb(&kec, row, sizeof(row));
     }
 
     sha3_pad(&kec, SHAKE_PAD);